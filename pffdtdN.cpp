@@ -265,7 +265,7 @@ int main(int argc, char*argv[])
     {
       printf("\t\\\\Plasma Parameters\n\tfp->%5.3f(MHz)\tfc->%5.3f(MHz)\tfg->%5.3f(MHz)\n\t@%5.3f elivation & %5.3f azmith\n",(FREQ_PLASMA/1e6),(FREQ_PLASMA*FREQ_COL/1e6),(FREQ_CYC/1e6),ANGLE_E_CYC,ANGLE_A_CYC);
       df = dt*FREQ_PLASMA; 
-//       printf("\t N_0 -> %5.3f, %5.3f, %5.3f 1/cc\n",N_0[i][j][k][l][0]*1e-6,N_0[i][j][k][l][1]*1e-6,N_0[i][j][k][l][2]*1e-6);
+//       printf("\t N_0 -> %5.3f, %5.3f, %5.3f 1/cc\n",N_0[i][j][k]*NPOP[0]*1e-6,N_0[i][j][k]*NPOP[1]*1e-6,N_0[i][j][k]*NPOP[2]*1e-6);
     }
 
   // Write header line for output files
@@ -1,72 +1,121 @@
 #include "field_calculator.h"
 #include <math.h>
+#include "material.h"
+#include "field_kernels.h"
+#include "tiling.h"
+#include "spans.h"
 
 // Global variables from pffdtd.cpp (Externs)
 extern double dt, dx, dy, dz;
 extern int sx, sy, sz;
-extern double ****EX, ****EY, ****EZ;
-extern double ****BX, ****BY, ****BZ;
-extern double ***ERX, ***ERY, ***ERZ;
+extern EBField EX, EY, EZ;
+extern EBField BX, BY, BZ;
+extern EBField BXP, BYP, BZP;
+
+// Row arguments of the E update
+static void Eargs(ERowArgs &a)
+{
+  a.ex = EX.base; a.ey = EY.base; a.ez = EZ.base;
+  a.bx = BX.base; a.by = BY.base; a.bz = BZ.base;
+  // Per material CA/CB (1 and 1/Er unless lossy), see material.h
+  a.mat = MAT.base;
+  a.cax = MATCAX; a.cay = MATCAY; a.caz = MATCAZ;
+  a.cbx = MATCBX; a.cby = MATCBY; a.cbz = MATCBZ;
+  a.si = EX.s[0]; a.sj = EX.s[1];
+  a.cdx = dt/(MU_0*EPSILON_0*dx);
+  a.cdy = dt/(MU_0*EPSILON_0*dy);
+  a.cdz = dt/(MU_0*EPSILON_0*dz);
+}
+
+// Row arguments of the B update, the new B goes over the oldest level (BXP..) or, with
+// inplace, over B itself (field only runs keep no second level in their blocks)
+static void Bargs(BRowArgs &a, int inplace)
+{
+  a.bx0 = BX.base; a.by0 = BY.base; a.bz0 = BZ.base;
+  if (inplace == 1)
+    {
+      a.bx1 = BX.base; a.by1 = BY.base; a.bz1 = BZ.base;
+    }
+  else
+    {
+      a.bx1 = BXP.base; a.by1 = BYP.base; a.bz1 = BZP.base;
+    }
+  a.ex = EX.base; a.ey = EY.base; a.ez = EZ.base;
+  a.si = BX.s[0]; a.sj = BX.s[1];
+  a.cdx = dt/dx;
+  a.cdy = dt/dy;
+  a.cdz = dt/dz;
+}
+
+// E of one k row segment, run by run with the broadcast kernel of each material, then
+// the PEC cells of the segment back to 0 (spans.h)
+static void Espan(const ERowArgs &a, long c, long n)
+{
+  SPANwalk(a, c, n, a.si, a.sj, Erowm, a.ex, a.ey, a.ez);
+}
 
 void Ecalc()
 {
-  int i, j, k;
-  double C_dx = dt/(MU_0*EPSILON_0*dx);
-  double C_dy = dt/(MU_0*EPSILON_0*dy);
-  double C_dz = dt/(MU_0*EPSILON_0*dz);
+  ERowArgs a;
+  double start = TILEclock();
 
+  Eargs(a);
 
   // Calculate the body (NOTE: One additional cell is added to eliminate the need for seperate loops for Ex, Ey, and EZ)
-  // Also ERX is actually 1/Er see setup2
-  for (i=2;i<sx;i++)
-    for (j=2;j<sy;j++)
-      for (k=2;k<sz;k++)
-	{
-	  // Save Old Values
-	  EX[i][j][k][0] = EX[i][j][k][1];
-	  EY[i][j][k][0] = EY[i][j][k][1];
-	  EZ[i][j][k][0] = EZ[i][j][k][1];
-
-	  // Calculate Ex
- 	  EX[i][j][k][1] = EX[i][j][k][0] + ( ( BZ[i][j+1][k][1] - BZ[i][j][k][1] ) * C_dy
-					    - ( BY[i][j][k+1][1] - BY[i][j][k][1] ) * C_dz ) * ERX[i][j][k];
- 		
-	  // Calculate Ey
- 	  EY[i][j][k][1] = EY[i][j][k][0] + ( ( BX[i][j][k+1][1] - BX[i][j][k][1] ) * C_dz
-					    - ( BZ[i+1][j][k][1] - BZ[i][j][k][1] ) * C_dx ) * ERY[i][j][k];
-		
-	  // Calculate Ez
- 	  EZ[i][j][k][1] = EZ[i][j][k][0] + ( ( BY[i+1][j][k][1] - BY[i][j][k][1] ) * C_dx
-					    - ( BX[i][j+1][k][1] - BX[i][j][k][1] ) * C_dy ) * ERZ[i][j][k];
-	}
+  // E is updated in place, only one time level is kept. The interior is swept tile by
+  // tile (tiling.h) and each material run of a k row segment goes to the vector row
+  // kernel of that material (field_kernels.h, spans.h)
+  TILEsweep(EX, Espan, a);
+
+  TILEcount(KERNEL_E, start, (double)(sx-2)*(sy-2)*(sz-2)*E_BYTES);
+}
+
+// E of the whole k rows of columns [ia,ib) x [ja,jb), serial (the callers in temporal.cpp
+// share the columns among the threads)
+void Erows(int ia, int ib, int ja, int jb)
+{
+  int i, j;
+  ERowArgs a;
 
+  Eargs(a);
+  for (i=ia;i<ib;i++)
+    for (j=ja;j<jb;j++)
+      Espan(a, EX.index(i,j,2), sz-2);
 }
 
 void Bcalc()
 {
-  int i,j,k;
-  double C_dx = dt/dx;
-  double C_dy = dt/dy;
-  double C_dz = dt/dz;
-
-  // Calculate the body
-  for (i=2;i<sx;i++)
-    for (j=2;j<sy;j++)
-      for (k=2;k<sz;k++)
-	{
-	  // Save Old Values
-	  BX[i][j][k][0] = BX[i][j][k][1];
-	  BY[i][j][k][0] = BY[i][j][k][1];
-	  BZ[i][j][k][0] = BZ[i][j][k][1];
-
-	  // Calculate Bx
-	  BX[i][j][k][1] = BX[i][j][k][0] + ( ( EY[i][j][k][1] - EY[i][j][k-1][1] ) * C_dz
-				          - ( EZ[i][j][k][1] - EZ[i][j-1][k][1] ) * C_dy );
-	  // Calculate By
-	  BY[i][j][k][1] = BY[i][j][k][0] + ( ( EZ[i][j][k][1] - EZ[i-1][j][k][1] ) * C_dx
-				          - ( EX[i][j][k][1] - EX[i][j][k-1][1] ) * C_dz );
-	  // Calculate Bz
-	  BZ[i][j][k][1] = BZ[i][j][k][0] + ( ( EX[i][j][k][1] - EX[i][j-1][k][1] ) * C_dy
-				          - ( EY[i][j][k][1] - EY[i-1][j][k][1] ) * C_dx );
-	}
+  BRowArgs a;
+  double start = TILEclock();
+
+  // The new B is written over the oldest level (BXP..), the two levels are then swapped
+  Bargs(a, 0);
+
+  // Calculate the body, tile by tile, one k row segment per kernel call
+  TILEsweep(BX, Brow, a);
+
+  // Save Old Values
+  Bswap();
+
+  TILEcount(KERNEL_B, start, (double)(sx-2)*(sy-2)*(sz-2)*B_BYTES);
+}
+
+// B of the whole k rows of columns [ia,ib) x [ja,jb), see Bargs for inplace, serial as Erows
+void Brows(int ia, int ib, int ja, int jb, int inplace)
+{
+  int i, j;
+  BRowArgs a;
+
+  Bargs(a, inplace);
+  for (i=ia;i<ib;i++)
+    for (j=ja;j<jb;j++)
+      Brow(a, BX.index(i,j,2), sz-2);
+}
+
+// Makes the B written over the oldest level the newest one
+void Bswap()
+{
+  swapfields(BX, BXP);
+  swapfields(BY, BYP);
+  swapfields(BZ, BZP);
 }
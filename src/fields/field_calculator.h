@@ -2,9 +2,14 @@
 #define FIELD_CALCULATOR_H
 
 #include "../utils/constants.h"
+#include "../utils/types.h"
 
 // Function Prototypes
 void Ecalc();
 void Bcalc();
+// Column pieces of the same updates for the blocked sweeps (temporal.h)
+void Erows(int ia, int ib, int ja, int jb);
+void Brows(int ia, int ib, int ja, int jb, int inplace);
+void Bswap();
 
 #endif // FIELD_CALCULATOR_H
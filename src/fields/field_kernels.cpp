@@ -0,0 +1,184 @@
+#include "field_kernels.h"
+#include <string.h>
+
+#if defined(FIELD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(FIELD_X86) && defined(__GNUC__)
+#include <cpuid.h>
+#endif
+
+ERowKernel Erow = Erow_scalar<0>;
+ERowMaterial Erowm = Erowm_scalar<0>;
+BRowKernel Brow = Brow_scalar<0>;
+int FIELD_UNIFORM = 0;
+
+static int field_isa = FIELD_SCALAR;           // Instruction set of the selected kernels
+static const char *field_names[] = {"scalar", "sse2", "avx2", "avx512"};
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Scalar row kernels (any CPU) /
+/////////////////////////////////
+template <int U>
+void Erowm_scalar(const ERowArgs &a, long c, long n, int m)
+{
+  long e;
+  const double cax = a.cax[m], cbx = U ? a.cbx[m]*a.cdx : a.cbx[m];
+  const double cay = a.cay[m], cby = U ? a.cby[m]*a.cdx : a.cby[m];
+  const double caz = a.caz[m], cbz = U ? a.cbz[m]*a.cdx : a.cbz[m];
+
+  for (e=c+n;c<e;c++)
+    Ecoef<U>(a, c, cax, cbx, cay, cby, caz, cbz);
+}
+
+template <int U>
+void Erow_scalar(const ERowArgs &a, long c, long n)
+{
+  long e;
+
+  if (Euniform(a.mat+c, n))
+    Erowm_scalar<U>(a, c, n, a.mat[c]);
+  else
+    for (e=c+n;c<e;c++)
+      Ecell<U>(a, c);
+}
+
+template <int U>
+void Brow_scalar(const BRowArgs &a, long c, long n)
+{
+  long e;
+
+  for (e=c+n;c<e;c++)
+    Bcell<U>(a, c);
+}
+
+template void Erowm_scalar<0>(const ERowArgs &a, long c, long n, int m);
+template void Erowm_scalar<1>(const ERowArgs &a, long c, long n, int m);
+template void Erow_scalar<0>(const ERowArgs &a, long c, long n);
+template void Erow_scalar<1>(const ERowArgs &a, long c, long n);
+template void Brow_scalar<0>(const BRowArgs &a, long c, long n);
+template void Brow_scalar<1>(const BRowArgs &a, long c, long n);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// CPU detection /
+//////////////////
+// Reads CPUID and checks that the OS saves the vector registers (XGETBV), an AVX-512 CPU
+// under an OS without ZMM state support only gets the AVX2 kernels.
+#ifdef FIELD_X86
+static void cpuid(unsigned leaf, unsigned sub, unsigned r[4])
+{
+#ifdef _MSC_VER
+  int v[4];
+  __cpuidex(v, (int)leaf, (int)sub);
+  r[0] = v[0]; r[1] = v[1]; r[2] = v[2]; r[3] = v[3];
+#else
+  __cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+}
+
+static unsigned long long xgetbv0()
+{
+#ifdef _MSC_VER
+  return _xgetbv(0);
+#else
+  unsigned lo, hi;
+  __asm__ __volatile__ ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+#endif
+
+int FIELDcpu()
+{
+  int isa = FIELD_SCALAR;
+#ifdef FIELD_X86
+  unsigned r[4], top;
+  unsigned long long xcr0 = 0;
+
+  cpuid(0, 0, r);
+  top = r[0];
+  if (top < 1)
+    return isa;
+  cpuid(1, 0, r);
+  if (r[3] & (1u << 26))                        // SSE2
+    isa = FIELD_SSE2;
+  if ((r[2] & (1u << 27)) == 0 || (r[2] & (1u << 28)) == 0 || top < 7) // OSXSAVE, AVX
+    return isa;
+  xcr0 = xgetbv0();
+  if ((xcr0 & 0x6) != 0x6)                      // XMM and YMM state
+    return isa;
+  cpuid(7, 0, r);
+  if (r[1] & (1u << 5))                         // AVX2
+    isa = FIELD_AVX2;
+  if ((r[1] & (1u << 16)) && (xcr0 & 0xe6) == 0xe6) // AVX512F, opmask and ZMM state
+    isa = FIELD_AVX512;
+#endif
+  return isa;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Kernel selection /
+/////////////////////
+template <int U>
+static void select(int isa)
+{
+  switch (isa)
+    {
+#ifdef FIELD_X86
+    case FIELD_SSE2:
+      Erow = Erow_sse2<U>;
+      Erowm = Erowm_sse2<U>;
+      Brow = Brow_sse2<U>;
+      break;
+    case FIELD_AVX2:
+      Erow = Erow_avx2<U>;
+      Erowm = Erowm_avx2<U>;
+      Brow = Brow_avx2<U>;
+      break;
+    case FIELD_AVX512:
+      Erow = Erow_avx512<U>;
+      Erowm = Erowm_avx512<U>;
+      Brow = Brow_avx512<U>;
+      break;
+#endif
+    default:
+      Erow = Erow_scalar<U>;
+      Erowm = Erowm_scalar<U>;
+      Brow = Brow_scalar<U>;
+    }
+}
+
+int FIELDselect(int isa)
+{
+  if ((isa < FIELD_SCALAR) || (isa > FIELDcpu()))
+    return 1;
+  field_isa = isa;
+  if (FIELD_UNIFORM)
+    select<1>(isa);
+  else
+    select<0>(isa);
+  return 0;
+}
+
+// The same instruction set, cubic cell forms on or off
+void FIELDuniform(int on)
+{
+  FIELD_UNIFORM = (on != 0) ? 1 : 0;
+  FIELDselect(field_isa);
+}
+
+int FIELDisa(const char *name)
+{
+  int isa;
+
+  for (isa=FIELD_SCALAR;isa<=FIELD_AVX512;isa++)
+    if (strcmp(name, field_names[isa]) == 0)
+      return isa;
+  return -1;
+}
+
+const char *FIELDname(int isa)
+{
+  if ((isa < FIELD_SCALAR) || (isa > FIELD_AVX512))
+    return "unknown";
+  return field_names[isa];
+}
@@ -0,0 +1,175 @@
+#ifndef FIELD_KERNELS_H
+#define FIELD_KERNELS_H
+
+#include "../utils/types.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Vector E/B row kernels /
+///////////////////////////
+// Ecalc and Bcalc walk the (i,j) rows of the grid and hand every k row to a row kernel.
+// There is one kernel per instruction set (scalar, SSE2, AVX2, AVX-512), each in its own
+// translation unit built with only that instruction set enabled, and FIELDselect picks
+// the best one the CPU supports at startup (CPUID), so one binary runs on every node.
+//
+// The vector kernels do the same multiplies and adds in the same order as the scalar one
+// and are built without FMA, the results are bit for bit the same on every variant.
+//
+// E uses the per material coefficients of material.h, E = CA*E + curl*CB. A row whose
+// cells are all of one material (vacuum almost everywhere) takes the uniform path: CA
+// and CB are broadcast once per row and the inner loop loads no coefficients at all.
+// Erowm is that path on its own, for callers that already know the material of a run
+// of cells (spans.h).
+//
+// The fields are ebreal (types.h). In float builds the kernels widen every load to
+// double and round once on the store, the scalar cell updates cast the first operand of
+// each difference so they do the same double arithmetic as the vector ones (the casts
+// do nothing in double builds).
+//
+// Every kernel comes in two forms, U = 0 for any cell and U = 1 for cubic cells
+// (dx = dy = dz, so cdx = cdy = cdz = cd). The cubic form takes the difference of the
+// two curl terms first and multiplies once by cb*cd (folded per material, or per row on
+// the uniform path): 1 multiply per component instead of 3 for E and 1 instead of 2 for
+// B. setup1 selects it when the spacing is equal (FIELDuniform). Both forms agree to
+// rounding, and every instruction set still gives bit for bit the same result as the
+// scalar kernel of the same form.
+
+// Instruction sets, in increasing order
+#define FIELD_SCALAR 0
+#define FIELD_SSE2 1
+#define FIELD_AVX2 2
+#define FIELD_AVX512 3
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define FIELD_X86                               // The SSE2/AVX2/AVX-512 kernels are built
+#endif
+
+// Everything an E row needs (Ecalc), c steps along k
+struct ERowArgs
+{
+  ebreal *ex, *ey, *ez;                         // Updated in place
+  const ebreal *bx, *by, *bz;
+  const unsigned char *mat;                     // Material map
+  const double *cax, *cay, *caz;                // E decay of each material (MATCAX..)
+  const double *cbx, *cby, *cbz;                // Curl gain of each material (MATCBX..)
+  long si, sj;                                  // i and j strides
+  double cdx, cdy, cdz;                         // dt/(MU_0*EPSILON_0*d?)
+};
+
+// Everything a B row needs (Bcalc), c steps along k
+struct BRowArgs
+{
+  const ebreal *bx0, *by0, *bz0;                // Current B
+  ebreal *bx1, *by1, *bz1;                      // New B
+  const ebreal *ex, *ey, *ez;
+  long si, sj;                                  // i and j strides
+  double cdx, cdy, cdz;                         // dt/d?
+};
+
+// Updates the n cells c, c+1, .. c+n-1 of one k row
+typedef void (*ERowKernel)(const ERowArgs &a, long c, long n);
+typedef void (*BRowKernel)(const BRowArgs &a, long c, long n);
+// The same for n cells that all have material m
+typedef void (*ERowMaterial)(const ERowArgs &a, long c, long n, int m);
+
+extern ERowKernel Erow;                         // Selected kernels (FIELDselect)
+extern BRowKernel Brow;
+extern ERowMaterial Erowm;
+extern int FIELD_UNIFORM;                       // 1 = the cubic cell forms are selected
+
+// Scalar cell updates, shared by the scalar kernels and the vector remainders. They are
+// static so every translation unit keeps its own copy built with its own instruction set.
+// For U = 1 the cb? passed in are already multiplied by cd.
+template <int U>
+static inline void Ecoef(const ERowArgs &a, long c, double cax, double cbx, double cay, double cby,
+			double caz, double cbz)
+{
+  if (U)
+    {
+      a.ex[c] = cax * a.ex[c] + ( ( (double)a.bz[c+a.sj] - a.bz[c] )
+				- ( (double)a.by[c+1] - a.by[c] ) ) * cbx;
+      a.ey[c] = cay * a.ey[c] + ( ( (double)a.bx[c+1] - a.bx[c] )
+				- ( (double)a.bz[c+a.si] - a.bz[c] ) ) * cby;
+      a.ez[c] = caz * a.ez[c] + ( ( (double)a.by[c+a.si] - a.by[c] )
+				- ( (double)a.bx[c+a.sj] - a.bx[c] ) ) * cbz;
+      return;
+    }
+  a.ex[c] = cax * a.ex[c] + ( ( (double)a.bz[c+a.sj] - a.bz[c] ) * a.cdy
+			    - ( (double)a.by[c+1] - a.by[c] ) * a.cdz ) * cbx;
+  a.ey[c] = cay * a.ey[c] + ( ( (double)a.bx[c+1] - a.bx[c] ) * a.cdz
+			    - ( (double)a.bz[c+a.si] - a.bz[c] ) * a.cdx ) * cby;
+  a.ez[c] = caz * a.ez[c] + ( ( (double)a.by[c+a.si] - a.by[c] ) * a.cdx
+			    - ( (double)a.bx[c+a.sj] - a.bx[c] ) * a.cdy ) * cbz;
+}
+
+// Ecoef with the coefficients of material m
+template <int U>
+static inline void Ematerial(const ERowArgs &a, long c, int m)
+{
+  if (U)
+    Ecoef<1>(a, c, a.cax[m], a.cbx[m]*a.cdx, a.cay[m], a.cby[m]*a.cdx, a.caz[m], a.cbz[m]*a.cdx);
+  else
+    Ecoef<0>(a, c, a.cax[m], a.cbx[m], a.cay[m], a.cby[m], a.caz[m], a.cbz[m]);
+}
+
+template <int U>
+static inline void Ecell(const ERowArgs &a, long c)
+{
+  Ematerial<U>(a, c, a.mat[c]);
+}
+
+// 1 if the n cells of the row at m share one material
+static inline int Euniform(const unsigned char *m, long n)
+{
+  long k;
+  unsigned char d = 0;
+
+  for (k=1;k<n;k++)
+    d |= (unsigned char)(m[k] ^ m[0]);
+  return d == 0;
+}
+
+template <int U>
+static inline void Bcell(const BRowArgs &a, long c)
+{
+  if (U)
+    {
+      a.bx1[c] = a.bx0[c] + ( ( (double)a.ey[c] - a.ey[c-1] )
+			    - ( (double)a.ez[c] - a.ez[c-a.sj] ) ) * a.cdx;
+      a.by1[c] = a.by0[c] + ( ( (double)a.ez[c] - a.ez[c-a.si] )
+			    - ( (double)a.ex[c] - a.ex[c-1] ) ) * a.cdx;
+      a.bz1[c] = a.bz0[c] + ( ( (double)a.ex[c] - a.ex[c-a.sj] )
+			    - ( (double)a.ey[c] - a.ey[c-a.si] ) ) * a.cdx;
+      return;
+    }
+  a.bx1[c] = a.bx0[c] + ( ( (double)a.ey[c] - a.ey[c-1] ) * a.cdz
+			- ( (double)a.ez[c] - a.ez[c-a.sj] ) * a.cdy );
+  a.by1[c] = a.by0[c] + ( ( (double)a.ez[c] - a.ez[c-a.si] ) * a.cdx
+			- ( (double)a.ex[c] - a.ex[c-1] ) * a.cdz );
+  a.bz1[c] = a.bz0[c] + ( ( (double)a.ex[c] - a.ex[c-a.sj] ) * a.cdy
+			- ( (double)a.ey[c] - a.ey[c-a.si] ) * a.cdx );
+}
+
+// Function Prototypes
+int FIELDcpu();                                 // Best instruction set of this CPU (CPUID)
+int FIELDselect(int isa);                       // Selects the kernels, 0 = ok, 1 = not supported
+void FIELDuniform(int on);                      // 1 = cubic cell forms (dx = dy = dz), 0 = general
+int FIELDisa(const char *name);                 // Instruction set from its name (-1 = unknown)
+const char *FIELDname(int isa);
+
+// Both forms of every kernel are instantiated in the kernel's own translation unit
+template <int U> void Erow_scalar(const ERowArgs &a, long c, long n);
+template <int U> void Erowm_scalar(const ERowArgs &a, long c, long n, int m);
+template <int U> void Brow_scalar(const BRowArgs &a, long c, long n);
+#ifdef FIELD_X86
+template <int U> void Erow_sse2(const ERowArgs &a, long c, long n);
+template <int U> void Erowm_sse2(const ERowArgs &a, long c, long n, int m);
+template <int U> void Brow_sse2(const BRowArgs &a, long c, long n);
+template <int U> void Erow_avx2(const ERowArgs &a, long c, long n);
+template <int U> void Erowm_avx2(const ERowArgs &a, long c, long n, int m);
+template <int U> void Brow_avx2(const BRowArgs &a, long c, long n);
+template <int U> void Erow_avx512(const ERowArgs &a, long c, long n);
+template <int U> void Erowm_avx512(const ERowArgs &a, long c, long n, int m);
+template <int U> void Brow_avx512(const BRowArgs &a, long c, long n);
+#endif
+
+#endif // FIELD_KERNELS_H
@@ -0,0 +1,163 @@
+// AVX2 row kernels (4 cells per step), built with AVX2 enabled (no FMA)
+#include "field_kernels.h"
+
+#ifdef FIELD_X86
+#include <immintrin.h>
+#include <string.h>
+
+// Loads and stores of 4 cells, float fields are widened to double (types.h)
+static inline __m256d vload(const double *p) { return _mm256_loadu_pd(p); }
+static inline void vstore(double *p, __m256d v) { _mm256_storeu_pd(p, v); }
+static inline __m256d vload(const float *p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+static inline void vstore(float *p, __m256d v) { _mm_storeu_ps(p, _mm256_cvtpd_ps(v)); }
+
+// Table entries of 4 cells, the masked form with a zero source keeps GCC from warning
+// about the undefined source of the plain gather
+static inline __m256d vgather(const double *t, __m128i id)
+{
+  return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), t, id, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8);
+}
+
+// 4 cells of E with the coefficients of each cell in ca?/cb? (for U = 1 cb? holds cb*cd)
+template <int U>
+static inline void Evec(const ERowArgs &a, long c, __m256d cdx, __m256d cdy, __m256d cdz,
+			__m256d cax, __m256d cbx, __m256d cay, __m256d cby, __m256d caz, __m256d cbz)
+{
+  __m256d bx, by, bz;
+
+  bx = vload(a.bx+c);
+  by = vload(a.by+c);
+  bz = vload(a.bz+c);
+  if (U)
+    {
+      vstore(a.ex+c, _mm256_add_pd(_mm256_mul_pd(cax, vload(a.ex+c)), _mm256_mul_pd(_mm256_sub_pd(
+	_mm256_sub_pd(vload(a.bz+c+a.sj), bz),
+	_mm256_sub_pd(vload(a.by+c+1), by)), cbx)));
+      vstore(a.ey+c, _mm256_add_pd(_mm256_mul_pd(cay, vload(a.ey+c)), _mm256_mul_pd(_mm256_sub_pd(
+	_mm256_sub_pd(vload(a.bx+c+1), bx),
+	_mm256_sub_pd(vload(a.bz+c+a.si), bz)), cby)));
+      vstore(a.ez+c, _mm256_add_pd(_mm256_mul_pd(caz, vload(a.ez+c)), _mm256_mul_pd(_mm256_sub_pd(
+	_mm256_sub_pd(vload(a.by+c+a.si), by),
+	_mm256_sub_pd(vload(a.bx+c+a.sj), bx)), cbz)));
+      return;
+    }
+  vstore(a.ex+c, _mm256_add_pd(_mm256_mul_pd(cax, vload(a.ex+c)), _mm256_mul_pd(_mm256_sub_pd(
+    _mm256_mul_pd(_mm256_sub_pd(vload(a.bz+c+a.sj), bz), cdy),
+    _mm256_mul_pd(_mm256_sub_pd(vload(a.by+c+1), by), cdz)), cbx)));
+  vstore(a.ey+c, _mm256_add_pd(_mm256_mul_pd(cay, vload(a.ey+c)), _mm256_mul_pd(_mm256_sub_pd(
+    _mm256_mul_pd(_mm256_sub_pd(vload(a.bx+c+1), bx), cdz),
+    _mm256_mul_pd(_mm256_sub_pd(vload(a.bz+c+a.si), bz), cdx)), cby)));
+  vstore(a.ez+c, _mm256_add_pd(_mm256_mul_pd(caz, vload(a.ez+c)), _mm256_mul_pd(_mm256_sub_pd(
+    _mm256_mul_pd(_mm256_sub_pd(vload(a.by+c+a.si), by), cdx),
+    _mm256_mul_pd(_mm256_sub_pd(vload(a.bx+c+a.sj), bx), cdy)), cbz)));
+}
+
+template <int U>
+void Erowm_avx2(const ERowArgs &a, long c, long n, int m)
+{
+  long e = c + n;
+  const __m256d cdx = _mm256_set1_pd(a.cdx), cdy = _mm256_set1_pd(a.cdy), cdz = _mm256_set1_pd(a.cdz);
+  const __m256d cax = _mm256_set1_pd(a.cax[m]), cbx = _mm256_set1_pd(U ? a.cbx[m]*a.cdx : a.cbx[m]);
+  const __m256d cay = _mm256_set1_pd(a.cay[m]), cby = _mm256_set1_pd(U ? a.cby[m]*a.cdx : a.cby[m]);
+  const __m256d caz = _mm256_set1_pd(a.caz[m]), cbz = _mm256_set1_pd(U ? a.cbz[m]*a.cdx : a.cbz[m]);
+
+  // The coefficients are broadcast once, no table loads in the loop
+  for (;c+4<=e;c+=4)
+    Evec<U>(a, c, cdx, cdy, cdz, cax, cbx, cay, cby, caz, cbz);
+  for (;c<e;c++)
+    Ematerial<U>(a, c, m);
+}
+
+template <int U>
+void Erow_avx2(const ERowArgs &a, long c, long n)
+{
+  long e = c + n;
+  const __m256d cdx = _mm256_set1_pd(a.cdx), cdy = _mm256_set1_pd(a.cdy), cdz = _mm256_set1_pd(a.cdz);
+  __m256d cax, cbx, cay, cby, caz, cbz;
+  __m128i id;
+  int m;
+
+  if (Euniform(a.mat+c, n))
+    {
+      Erowm_avx2<U>(a, c, n, a.mat[c]);
+      return;
+    }
+  for (;c+4<=e;c+=4)
+    {
+      // Coefficients of 4 cells, the material bytes widened to 32 bit table indices
+      memcpy(&m, a.mat+c, 4);
+      id = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(m));
+      cax = vgather(a.cax, id);
+      cbx = vgather(a.cbx, id);
+      cay = vgather(a.cay, id);
+      cby = vgather(a.cby, id);
+      caz = vgather(a.caz, id);
+      cbz = vgather(a.cbz, id);
+      if (U)
+	{
+	  // Cubic cells: cb*cd, the same product Erowm takes once per row
+	  cbx = _mm256_mul_pd(cbx, cdx);
+	  cby = _mm256_mul_pd(cby, cdx);
+	  cbz = _mm256_mul_pd(cbz, cdx);
+	}
+      Evec<U>(a, c, cdx, cdy, cdz, cax, cbx, cay, cby, caz, cbz);
+    }
+  for (;c<e;c++)
+    Ecell<U>(a, c);
+}
+
+template <int U>
+void Brow_avx2(const BRowArgs &a, long c, long n)
+{
+  long e = c + n;
+  const __m256d cdx = _mm256_set1_pd(a.cdx), cdy = _mm256_set1_pd(a.cdy), cdz = _mm256_set1_pd(a.cdz);
+  __m256d ex, ey, ez;
+
+  if (U)
+    {
+      for (;c+4<=e;c+=4)
+	{
+	  ex = vload(a.ex+c);
+	  ey = vload(a.ey+c);
+	  ez = vload(a.ez+c);
+	  vstore(a.bx1+c, _mm256_add_pd(vload(a.bx0+c), _mm256_mul_pd(_mm256_sub_pd(
+	    _mm256_sub_pd(ey, vload(a.ey+c-1)),
+	    _mm256_sub_pd(ez, vload(a.ez+c-a.sj))), cdx)));
+	  vstore(a.by1+c, _mm256_add_pd(vload(a.by0+c), _mm256_mul_pd(_mm256_sub_pd(
+	    _mm256_sub_pd(ez, vload(a.ez+c-a.si)),
+	    _mm256_sub_pd(ex, vload(a.ex+c-1))), cdx)));
+	  vstore(a.bz1+c, _mm256_add_pd(vload(a.bz0+c), _mm256_mul_pd(_mm256_sub_pd(
+	    _mm256_sub_pd(ex, vload(a.ex+c-a.sj)),
+	    _mm256_sub_pd(ey, vload(a.ey+c-a.si))), cdx)));
+	}
+      for (;c<e;c++)
+	Bcell<1>(a, c);
+      return;
+    }
+  for (;c+4<=e;c+=4)
+    {
+      ex = vload(a.ex+c);
+      ey = vload(a.ey+c);
+      ez = vload(a.ez+c);
+      vstore(a.bx1+c, _mm256_add_pd(vload(a.bx0+c), _mm256_sub_pd(
+	_mm256_mul_pd(_mm256_sub_pd(ey, vload(a.ey+c-1)), cdz),
+	_mm256_mul_pd(_mm256_sub_pd(ez, vload(a.ez+c-a.sj)), cdy))));
+      vstore(a.by1+c, _mm256_add_pd(vload(a.by0+c), _mm256_sub_pd(
+	_mm256_mul_pd(_mm256_sub_pd(ez, vload(a.ez+c-a.si)), cdx),
+	_mm256_mul_pd(_mm256_sub_pd(ex, vload(a.ex+c-1)), cdz))));
+      vstore(a.bz1+c, _mm256_add_pd(vload(a.bz0+c), _mm256_sub_pd(
+	_mm256_mul_pd(_mm256_sub_pd(ex, vload(a.ex+c-a.sj)), cdy),
+	_mm256_mul_pd(_mm256_sub_pd(ey, vload(a.ey+c-a.si)), cdx))));
+    }
+  for (;c<e;c++)
+    Bcell<U>(a, c);
+}
+
+template void Erowm_avx2<0>(const ERowArgs &a, long c, long n, int m);
+template void Erowm_avx2<1>(const ERowArgs &a, long c, long n, int m);
+template void Erow_avx2<0>(const ERowArgs &a, long c, long n);
+template void Erow_avx2<1>(const ERowArgs &a, long c, long n);
+template void Brow_avx2<0>(const BRowArgs &a, long c, long n);
+template void Brow_avx2<1>(const BRowArgs &a, long c, long n);
+
+#endif // FIELD_X86
@@ -0,0 +1,161 @@
+// AVX-512 row kernels (8 cells per step), built with AVX-512F enabled (no FMA)
+#include "field_kernels.h"
+
+#ifdef FIELD_X86
+#include <immintrin.h>
+
+// Loads and stores of 8 cells, float fields are widened to double (types.h), the
+// conversions in the zero masked form for the same reason as vgather below
+static inline __m512d vload(const double *p) { return _mm512_loadu_pd(p); }
+static inline void vstore(double *p, __m512d v) { _mm512_storeu_pd(p, v); }
+static inline __m512d vload(const float *p) { return _mm512_maskz_cvtps_pd(0xff, _mm256_loadu_ps(p)); }
+static inline void vstore(float *p, __m512d v) { _mm256_storeu_ps(p, _mm512_maskz_cvtpd_ps(0xff, v)); }
+
+// Table entries of 8 cells, the masked form with a zero source keeps GCC from warning
+// about the undefined source of the plain gather
+static inline __m512d vgather(const double *t, __m256i id)
+{
+  return _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xff, id, t, 8);
+}
+
+// 8 cells of E with the coefficients of each cell in ca?/cb? (for U = 1 cb? holds cb*cd)
+template <int U>
+static inline void Evec(const ERowArgs &a, long c, __m512d cdx, __m512d cdy, __m512d cdz,
+			__m512d cax, __m512d cbx, __m512d cay, __m512d cby, __m512d caz, __m512d cbz)
+{
+  __m512d bx, by, bz;
+
+  bx = vload(a.bx+c);
+  by = vload(a.by+c);
+  bz = vload(a.bz+c);
+  if (U)
+    {
+      vstore(a.ex+c, _mm512_add_pd(_mm512_mul_pd(cax, vload(a.ex+c)), _mm512_mul_pd(_mm512_sub_pd(
+	_mm512_sub_pd(vload(a.bz+c+a.sj), bz),
+	_mm512_sub_pd(vload(a.by+c+1), by)), cbx)));
+      vstore(a.ey+c, _mm512_add_pd(_mm512_mul_pd(cay, vload(a.ey+c)), _mm512_mul_pd(_mm512_sub_pd(
+	_mm512_sub_pd(vload(a.bx+c+1), bx),
+	_mm512_sub_pd(vload(a.bz+c+a.si), bz)), cby)));
+      vstore(a.ez+c, _mm512_add_pd(_mm512_mul_pd(caz, vload(a.ez+c)), _mm512_mul_pd(_mm512_sub_pd(
+	_mm512_sub_pd(vload(a.by+c+a.si), by),
+	_mm512_sub_pd(vload(a.bx+c+a.sj), bx)), cbz)));
+      return;
+    }
+  vstore(a.ex+c, _mm512_add_pd(_mm512_mul_pd(cax, vload(a.ex+c)), _mm512_mul_pd(_mm512_sub_pd(
+    _mm512_mul_pd(_mm512_sub_pd(vload(a.bz+c+a.sj), bz), cdy),
+    _mm512_mul_pd(_mm512_sub_pd(vload(a.by+c+1), by), cdz)), cbx)));
+  vstore(a.ey+c, _mm512_add_pd(_mm512_mul_pd(cay, vload(a.ey+c)), _mm512_mul_pd(_mm512_sub_pd(
+    _mm512_mul_pd(_mm512_sub_pd(vload(a.bx+c+1), bx), cdz),
+    _mm512_mul_pd(_mm512_sub_pd(vload(a.bz+c+a.si), bz), cdx)), cby)));
+  vstore(a.ez+c, _mm512_add_pd(_mm512_mul_pd(caz, vload(a.ez+c)), _mm512_mul_pd(_mm512_sub_pd(
+    _mm512_mul_pd(_mm512_sub_pd(vload(a.by+c+a.si), by), cdx),
+    _mm512_mul_pd(_mm512_sub_pd(vload(a.bx+c+a.sj), bx), cdy)), cbz)));
+}
+
+template <int U>
+void Erowm_avx512(const ERowArgs &a, long c, long n, int m)
+{
+  long e = c + n;
+  const __m512d cdx = _mm512_set1_pd(a.cdx), cdy = _mm512_set1_pd(a.cdy), cdz = _mm512_set1_pd(a.cdz);
+  const __m512d cax = _mm512_set1_pd(a.cax[m]), cbx = _mm512_set1_pd(U ? a.cbx[m]*a.cdx : a.cbx[m]);
+  const __m512d cay = _mm512_set1_pd(a.cay[m]), cby = _mm512_set1_pd(U ? a.cby[m]*a.cdx : a.cby[m]);
+  const __m512d caz = _mm512_set1_pd(a.caz[m]), cbz = _mm512_set1_pd(U ? a.cbz[m]*a.cdx : a.cbz[m]);
+
+  // The coefficients are broadcast once, no table loads in the loop
+  for (;c+8<=e;c+=8)
+    Evec<U>(a, c, cdx, cdy, cdz, cax, cbx, cay, cby, caz, cbz);
+  for (;c<e;c++)
+    Ematerial<U>(a, c, m);
+}
+
+template <int U>
+void Erow_avx512(const ERowArgs &a, long c, long n)
+{
+  long e = c + n;
+  const __m512d cdx = _mm512_set1_pd(a.cdx), cdy = _mm512_set1_pd(a.cdy), cdz = _mm512_set1_pd(a.cdz);
+  __m512d cax, cbx, cay, cby, caz, cbz;
+  __m256i id;
+
+  if (Euniform(a.mat+c, n))
+    {
+      Erowm_avx512<U>(a, c, n, a.mat[c]);
+      return;
+    }
+  for (;c+8<=e;c+=8)
+    {
+      // Coefficients of 8 cells, the material bytes widened to 32 bit table indices
+      id = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(a.mat+c)));
+      cax = vgather(a.cax, id);
+      cbx = vgather(a.cbx, id);
+      cay = vgather(a.cay, id);
+      cby = vgather(a.cby, id);
+      caz = vgather(a.caz, id);
+      cbz = vgather(a.cbz, id);
+      if (U)
+	{
+	  // Cubic cells: cb*cd, the same product Erowm takes once per row
+	  cbx = _mm512_mul_pd(cbx, cdx);
+	  cby = _mm512_mul_pd(cby, cdx);
+	  cbz = _mm512_mul_pd(cbz, cdx);
+	}
+      Evec<U>(a, c, cdx, cdy, cdz, cax, cbx, cay, cby, caz, cbz);
+    }
+  for (;c<e;c++)
+    Ecell<U>(a, c);
+}
+
+template <int U>
+void Brow_avx512(const BRowArgs &a, long c, long n)
+{
+  long e = c + n;
+  const __m512d cdx = _mm512_set1_pd(a.cdx), cdy = _mm512_set1_pd(a.cdy), cdz = _mm512_set1_pd(a.cdz);
+  __m512d ex, ey, ez;
+
+  if (U)
+    {
+      for (;c+8<=e;c+=8)
+	{
+	  ex = vload(a.ex+c);
+	  ey = vload(a.ey+c);
+	  ez = vload(a.ez+c);
+	  vstore(a.bx1+c, _mm512_add_pd(vload(a.bx0+c), _mm512_mul_pd(_mm512_sub_pd(
+	    _mm512_sub_pd(ey, vload(a.ey+c-1)),
+	    _mm512_sub_pd(ez, vload(a.ez+c-a.sj))), cdx)));
+	  vstore(a.by1+c, _mm512_add_pd(vload(a.by0+c), _mm512_mul_pd(_mm512_sub_pd(
+	    _mm512_sub_pd(ez, vload(a.ez+c-a.si)),
+	    _mm512_sub_pd(ex, vload(a.ex+c-1))), cdx)));
+	  vstore(a.bz1+c, _mm512_add_pd(vload(a.bz0+c), _mm512_mul_pd(_mm512_sub_pd(
+	    _mm512_sub_pd(ex, vload(a.ex+c-a.sj)),
+	    _mm512_sub_pd(ey, vload(a.ey+c-a.si))), cdx)));
+	}
+      for (;c<e;c++)
+	Bcell<1>(a, c);
+      return;
+    }
+  for (;c+8<=e;c+=8)
+    {
+      ex = vload(a.ex+c);
+      ey = vload(a.ey+c);
+      ez = vload(a.ez+c);
+      vstore(a.bx1+c, _mm512_add_pd(vload(a.bx0+c), _mm512_sub_pd(
+	_mm512_mul_pd(_mm512_sub_pd(ey, vload(a.ey+c-1)), cdz),
+	_mm512_mul_pd(_mm512_sub_pd(ez, vload(a.ez+c-a.sj)), cdy))));
+      vstore(a.by1+c, _mm512_add_pd(vload(a.by0+c), _mm512_sub_pd(
+	_mm512_mul_pd(_mm512_sub_pd(ez, vload(a.ez+c-a.si)), cdx),
+	_mm512_mul_pd(_mm512_sub_pd(ex, vload(a.ex+c-1)), cdz))));
+      vstore(a.bz1+c, _mm512_add_pd(vload(a.bz0+c), _mm512_sub_pd(
+	_mm512_mul_pd(_mm512_sub_pd(ex, vload(a.ex+c-a.sj)), cdy),
+	_mm512_mul_pd(_mm512_sub_pd(ey, vload(a.ey+c-a.si)), cdx))));
+    }
+  for (;c<e;c++)
+    Bcell<U>(a, c);
+}
+
+template void Erowm_avx512<0>(const ERowArgs &a, long c, long n, int m);
+template void Erowm_avx512<1>(const ERowArgs &a, long c, long n, int m);
+template void Erow_avx512<0>(const ERowArgs &a, long c, long n);
+template void Erow_avx512<1>(const ERowArgs &a, long c, long n);
+template void Brow_avx512<0>(const BRowArgs &a, long c, long n);
+template void Brow_avx512<1>(const BRowArgs &a, long c, long n);
+
+#endif // FIELD_X86
@@ -0,0 +1,151 @@
+// SSE2 row kernels (2 cells per step), built with SSE2 enabled
+#include "field_kernels.h"
+
+#ifdef FIELD_X86
+#include <emmintrin.h>
+
+// Loads and stores of 2 cells, float fields are widened to double (types.h)
+static inline __m128d vload(const double *p) { return _mm_loadu_pd(p); }
+static inline void vstore(double *p, __m128d v) { _mm_storeu_pd(p, v); }
+static inline __m128d vload(const float *p) { return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)p))); }
+static inline void vstore(float *p, __m128d v) { _mm_storel_epi64((__m128i *)p, _mm_castps_si128(_mm_cvtpd_ps(v))); }
+
+// 2 cells of E with the coefficients of each cell in ca?/cb? (for U = 1 cb? holds cb*cd)
+template <int U>
+static inline void Evec(const ERowArgs &a, long c, __m128d cdx, __m128d cdy, __m128d cdz,
+			__m128d cax, __m128d cbx, __m128d cay, __m128d cby, __m128d caz, __m128d cbz)
+{
+  __m128d bx, by, bz;
+
+  bx = vload(a.bx+c);
+  by = vload(a.by+c);
+  bz = vload(a.bz+c);
+  if (U)
+    {
+      vstore(a.ex+c, _mm_add_pd(_mm_mul_pd(cax, vload(a.ex+c)), _mm_mul_pd(_mm_sub_pd(
+	_mm_sub_pd(vload(a.bz+c+a.sj), bz),
+	_mm_sub_pd(vload(a.by+c+1), by)), cbx)));
+      vstore(a.ey+c, _mm_add_pd(_mm_mul_pd(cay, vload(a.ey+c)), _mm_mul_pd(_mm_sub_pd(
+	_mm_sub_pd(vload(a.bx+c+1), bx),
+	_mm_sub_pd(vload(a.bz+c+a.si), bz)), cby)));
+      vstore(a.ez+c, _mm_add_pd(_mm_mul_pd(caz, vload(a.ez+c)), _mm_mul_pd(_mm_sub_pd(
+	_mm_sub_pd(vload(a.by+c+a.si), by),
+	_mm_sub_pd(vload(a.bx+c+a.sj), bx)), cbz)));
+      return;
+    }
+  vstore(a.ex+c, _mm_add_pd(_mm_mul_pd(cax, vload(a.ex+c)), _mm_mul_pd(_mm_sub_pd(
+    _mm_mul_pd(_mm_sub_pd(vload(a.bz+c+a.sj), bz), cdy),
+    _mm_mul_pd(_mm_sub_pd(vload(a.by+c+1), by), cdz)), cbx)));
+  vstore(a.ey+c, _mm_add_pd(_mm_mul_pd(cay, vload(a.ey+c)), _mm_mul_pd(_mm_sub_pd(
+    _mm_mul_pd(_mm_sub_pd(vload(a.bx+c+1), bx), cdz),
+    _mm_mul_pd(_mm_sub_pd(vload(a.bz+c+a.si), bz), cdx)), cby)));
+  vstore(a.ez+c, _mm_add_pd(_mm_mul_pd(caz, vload(a.ez+c)), _mm_mul_pd(_mm_sub_pd(
+    _mm_mul_pd(_mm_sub_pd(vload(a.by+c+a.si), by), cdx),
+    _mm_mul_pd(_mm_sub_pd(vload(a.bx+c+a.sj), bx), cdy)), cbz)));
+}
+
+template <int U>
+void Erowm_sse2(const ERowArgs &a, long c, long n, int m)
+{
+  long e = c + n;
+  const __m128d cdx = _mm_set1_pd(a.cdx), cdy = _mm_set1_pd(a.cdy), cdz = _mm_set1_pd(a.cdz);
+  const __m128d cax = _mm_set1_pd(a.cax[m]), cbx = _mm_set1_pd(U ? a.cbx[m]*a.cdx : a.cbx[m]);
+  const __m128d cay = _mm_set1_pd(a.cay[m]), cby = _mm_set1_pd(U ? a.cby[m]*a.cdx : a.cby[m]);
+  const __m128d caz = _mm_set1_pd(a.caz[m]), cbz = _mm_set1_pd(U ? a.cbz[m]*a.cdx : a.cbz[m]);
+
+  // The coefficients are broadcast once, no table loads in the loop
+  for (;c+2<=e;c+=2)
+    Evec<U>(a, c, cdx, cdy, cdz, cax, cbx, cay, cby, caz, cbz);
+  for (;c<e;c++)
+    Ematerial<U>(a, c, m);
+}
+
+template <int U>
+void Erow_sse2(const ERowArgs &a, long c, long n)
+{
+  long e = c + n;
+  const __m128d cdx = _mm_set1_pd(a.cdx), cdy = _mm_set1_pd(a.cdy), cdz = _mm_set1_pd(a.cdz);
+  __m128d cax, cbx, cay, cby, caz, cbz;
+
+  if (Euniform(a.mat+c, n))
+    {
+      Erowm_sse2<U>(a, c, n, a.mat[c]);
+      return;
+    }
+  for (;c+2<=e;c+=2)
+    {
+      // No gather in SSE2, the tables are read per cell
+      cax = _mm_set_pd(a.cax[a.mat[c+1]], a.cax[a.mat[c]]);
+      cbx = _mm_set_pd(a.cbx[a.mat[c+1]], a.cbx[a.mat[c]]);
+      cay = _mm_set_pd(a.cay[a.mat[c+1]], a.cay[a.mat[c]]);
+      cby = _mm_set_pd(a.cby[a.mat[c+1]], a.cby[a.mat[c]]);
+      caz = _mm_set_pd(a.caz[a.mat[c+1]], a.caz[a.mat[c]]);
+      cbz = _mm_set_pd(a.cbz[a.mat[c+1]], a.cbz[a.mat[c]]);
+      if (U)
+	{
+	  // Cubic cells: cb*cd, the same product Erowm takes once per row
+	  cbx = _mm_mul_pd(cbx, cdx);
+	  cby = _mm_mul_pd(cby, cdx);
+	  cbz = _mm_mul_pd(cbz, cdx);
+	}
+      Evec<U>(a, c, cdx, cdy, cdz, cax, cbx, cay, cby, caz, cbz);
+    }
+  for (;c<e;c++)
+    Ecell<U>(a, c);
+}
+
+template <int U>
+void Brow_sse2(const BRowArgs &a, long c, long n)
+{
+  long e = c + n;
+  const __m128d cdx = _mm_set1_pd(a.cdx), cdy = _mm_set1_pd(a.cdy), cdz = _mm_set1_pd(a.cdz);
+  __m128d ex, ey, ez;
+
+  if (U)
+    {
+      for (;c+2<=e;c+=2)
+	{
+	  ex = vload(a.ex+c);
+	  ey = vload(a.ey+c);
+	  ez = vload(a.ez+c);
+	  vstore(a.bx1+c, _mm_add_pd(vload(a.bx0+c), _mm_mul_pd(_mm_sub_pd(
+	    _mm_sub_pd(ey, vload(a.ey+c-1)),
+	    _mm_sub_pd(ez, vload(a.ez+c-a.sj))), cdx)));
+	  vstore(a.by1+c, _mm_add_pd(vload(a.by0+c), _mm_mul_pd(_mm_sub_pd(
+	    _mm_sub_pd(ez, vload(a.ez+c-a.si)),
+	    _mm_sub_pd(ex, vload(a.ex+c-1))), cdx)));
+	  vstore(a.bz1+c, _mm_add_pd(vload(a.bz0+c), _mm_mul_pd(_mm_sub_pd(
+	    _mm_sub_pd(ex, vload(a.ex+c-a.sj)),
+	    _mm_sub_pd(ey, vload(a.ey+c-a.si))), cdx)));
+	}
+      for (;c<e;c++)
+	Bcell<1>(a, c);
+      return;
+    }
+  for (;c+2<=e;c+=2)
+    {
+      ex = vload(a.ex+c);
+      ey = vload(a.ey+c);
+      ez = vload(a.ez+c);
+      vstore(a.bx1+c, _mm_add_pd(vload(a.bx0+c), _mm_sub_pd(
+	_mm_mul_pd(_mm_sub_pd(ey, vload(a.ey+c-1)), cdz),
+	_mm_mul_pd(_mm_sub_pd(ez, vload(a.ez+c-a.sj)), cdy))));
+      vstore(a.by1+c, _mm_add_pd(vload(a.by0+c), _mm_sub_pd(
+	_mm_mul_pd(_mm_sub_pd(ez, vload(a.ez+c-a.si)), cdx),
+	_mm_mul_pd(_mm_sub_pd(ex, vload(a.ex+c-1)), cdz))));
+      vstore(a.bz1+c, _mm_add_pd(vload(a.bz0+c), _mm_sub_pd(
+	_mm_mul_pd(_mm_sub_pd(ex, vload(a.ex+c-a.sj)), cdy),
+	_mm_mul_pd(_mm_sub_pd(ey, vload(a.ey+c-a.si)), cdx))));
+    }
+  for (;c<e;c++)
+    Bcell<U>(a, c);
+}
+
+template void Erowm_sse2<0>(const ERowArgs &a, long c, long n, int m);
+template void Erowm_sse2<1>(const ERowArgs &a, long c, long n, int m);
+template void Erow_sse2<0>(const ERowArgs &a, long c, long n);
+template void Erow_sse2<1>(const ERowArgs &a, long c, long n);
+template void Brow_sse2<0>(const BRowArgs &a, long c, long n);
+template void Brow_sse2<1>(const BRowArgs &a, long c, long n);
+
+#endif // FIELD_X86
@@ -0,0 +1,86 @@
+#include "material.h"
+#include "../utils/memallocate.h"
+#include "../utils/constants.h"
+
+extern int sx, sy, sz;
+extern double dt;
+
+IdField MAT;                                    // Material ID of every cell
+double MATERX[256], MATERY[256], MATERZ[256];   // 1/Er of each component
+double MATQF[256];                              // Charging factor (1 or Charge)
+double MATSIG[256];                             // Conductivity (0 or 1)
+double MATCAX[256], MATCAY[256], MATCAZ[256];   // E decay of each component (CA)
+double MATCBX[256], MATCBY[256], MATCBZ[256];   // Curl gain of each component (CB)
+
+void MATallocate()
+{
+  int lo[3] = {1, 1, 1};
+  int hi[3] = {sx, sy, sz};
+
+  MAT = fieldalloc<unsigned char>(3, lo, hi, "MAT");
+}
+
+// Every cell is vacuum, no charging and no plasma
+void MATclear()
+{
+  int i, j, k;
+
+  SLAB_FOR(j, k)
+  for (i=1;i<=sx;i++)
+    for (j=1;j<=sy;j++)
+      for (k=1;k<=sz;k++)
+	MAT(i,j,k) = 0;
+  MATtables(1, 1, 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Fills the lookup tables (ER1, ER2 are the relative permittivities read by setup2) /
+//////////////////////////////////////////////////////////////////////////////////////
+void MATtables(double ER1, double ER2, double charge, double SG1, double SG2)
+{
+  int id, cls;
+  double er[4], ca[4], cb[4], l;
+
+  er[MAT_VACUUM] = 1;
+  er[MAT_PEC] = 0;
+  er[MAT_ER1] = 1/ER1;
+  er[MAT_ER2] = 1/ER2;
+  // Vacuum and PEC are lossless (PEC keeps CB = 0, E never changes)
+  for (cls=0;cls<4;cls++)
+    {
+      ca[cls] = 1;
+      cb[cls] = er[cls];
+    }
+  if (SG1 != 0)
+    {
+      l = SG1*dt/(2*EPSILON_0*ER1);
+      ca[MAT_ER1] = (1-l)/(1+l);
+      cb[MAT_ER1] = er[MAT_ER1]/(1+l);
+    }
+  if (SG2 != 0)
+    {
+      l = SG2*dt/(2*EPSILON_0*ER2);
+      ca[MAT_ER2] = (1-l)/(1+l);
+      cb[MAT_ER2] = er[MAT_ER2]/(1+l);
+    }
+  for (id=0;id<256;id++)
+    {
+      MATERX[id] = er[(id >> MAT_SHX) & MAT_CLASS];
+      MATERY[id] = er[(id >> MAT_SHY) & MAT_CLASS];
+      MATERZ[id] = er[(id >> MAT_SHZ) & MAT_CLASS];
+      MATCAX[id] = ca[(id >> MAT_SHX) & MAT_CLASS];
+      MATCAY[id] = ca[(id >> MAT_SHY) & MAT_CLASS];
+      MATCAZ[id] = ca[(id >> MAT_SHZ) & MAT_CLASS];
+      MATCBX[id] = cb[(id >> MAT_SHX) & MAT_CLASS];
+      MATCBY[id] = cb[(id >> MAT_SHY) & MAT_CLASS];
+      MATCBZ[id] = cb[(id >> MAT_SHZ) & MAT_CLASS];
+      MATQF[id] = (id & MAT_QF) ? charge : 1;
+      MATSIG[id] = (id & MAT_SIG) ? 1.0 : 0;
+    }
+}
+
+// Sets the class of one E component (shift = MAT_SHX, MAT_SHY or MAT_SHZ)
+void MATsetclass(int i, int j, int k, int shift, int cls)
+{
+  MAT(i,j,k) = (unsigned char) ((MAT(i,j,k) & ~(MAT_CLASS << shift)) | (cls << shift));
+}
@@ -0,0 +1,52 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include "../utils/types.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Material map /
+/////////////////
+// Every cell holds one byte that replaces the old ERX/ERY/ERZ, QF and SIG double arrays.
+// setup2 only ever assigns a handful of values to them, so the byte is a set of small
+// fields and the coefficients are read back through 256 entry lookup tables, e.g.
+// ERX(i,j,k) is MATERX[MAT(i,j,k)].
+//
+//   bits 0-1  class of Ex (MAT_VACUUM, MAT_PEC, MAT_ER1, MAT_ER2)
+//   bits 2-3  class of Ey
+//   bits 4-5  class of Ez
+//   bit  6    MAT_QF  charging factor (antenna cell, electrons only)
+//   bit  7    MAT_SIG plasma present
+//
+// The E update uses per material coefficients, E = CA*E + (curl terms)*CB, built once
+// by MATtables. With a conductivity s (S/m) the dielectrics are lossy through the same
+// formula: with l = s*dt/(2*EPSILON_0*Er), CA = (1-l)/(1+l) and CB = (1/Er)/(1+l).
+// Lossless cells have CA = 1 and CB = 1/Er, exactly the old update.
+
+// Classes of one E component (1/Er = 1, 0, 1/ER[0], 1/ER[1])
+#define MAT_VACUUM 0
+#define MAT_PEC 1
+#define MAT_ER1 2
+#define MAT_ER2 3
+
+#define MAT_SHX 0                               // Bit position of the Ex/Ey/Ez class
+#define MAT_SHY 2
+#define MAT_SHZ 4
+#define MAT_CLASS 3                             // Mask of one class after shifting
+#define MAT_QF 0x40
+#define MAT_SIG 0x80
+
+extern IdField MAT;                             // Material ID of every cell
+extern double MATERX[256], MATERY[256], MATERZ[256]; // 1/Er of each component
+extern double MATQF[256];                       // Charging factor (1 or Charge)
+extern double MATSIG[256];                      // Conductivity (0 or 1)
+extern double MATCAX[256], MATCAY[256], MATCAZ[256]; // E decay of each component (CA)
+extern double MATCBX[256], MATCBY[256], MATCBZ[256]; // Curl gain of each component (CB)
+
+// Function Prototypes
+void MATallocate();
+void MATclear();
+// SG1, SG2 are the conductivities of the two dielectrics (needs dt when not 0)
+void MATtables(double ER1, double ER2, double charge, double SG1 = 0, double SG2 = 0);
+void MATsetclass(int i, int j, int k, int shift, int cls);
+
+#endif // MATERIAL_H
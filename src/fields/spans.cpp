@@ -0,0 +1,130 @@
+#include "spans.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "material.h"
+
+long *SROW = NULL;                              // First run of each interior row
+Span *SPANS = NULL;                             // Runs of all rows
+long *PROW = NULL;                              // First PEC cell of each interior row
+Pec *PECS = NULL;                               // PEC cells of all rows
+
+int SPANclass(int id)
+{
+  int x = (id >> MAT_SHX) & MAT_CLASS, y = (id >> MAT_SHY) & MAT_CLASS, z = (id >> MAT_SHZ) & MAT_CLASS;
+
+  if (id & MAT_SIG)
+    return SPAN_PLASMA;
+  if ((x == MAT_PEC) || (y == MAT_PEC) || (z == MAT_PEC))
+    return SPAN_PEC;
+  if ((x != MAT_VACUUM) || (y != MAT_VACUUM) || (z != MAT_VACUUM))
+    return SPAN_DIELECTRIC;
+  return SPAN_VACUUM;
+}
+
+int SPANbulk(int id)
+{
+  int sh;
+
+  for (sh=MAT_SHX;sh<=MAT_SHZ;sh+=MAT_SHY-MAT_SHX)
+    if (((id >> sh) & MAT_CLASS) == MAT_PEC)
+      id &= ~(MAT_CLASS << sh);
+  return id;
+}
+
+// PEC components of a material (PEC_X..)
+static int pecmask(int id)
+{
+  return ((((id >> MAT_SHX) & MAT_CLASS) == MAT_PEC) ? PEC_X : 0)
+    | ((((id >> MAT_SHY) & MAT_CLASS) == MAT_PEC) ? PEC_Y : 0)
+    | ((((id >> MAT_SHZ) & MAT_CLASS) == MAT_PEC) ? PEC_Z : 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Run length encodes the interior rows of MAT (counts the runs, then fills them) /
+///////////////////////////////////////////////////////////////////////////////////
+void SPANbuild()
+{
+  int i, j, k, k0, id, pass;
+  long r, n, e;
+
+  SPANfree();
+  for (pass=0;pass<2;pass++)
+    {
+      n = e = 0;
+      r = 0;
+      for (i=2;i<sx;i++)
+	for (j=2;j<sy;j++,r++)
+	  {
+	    if (pass == 1)
+	      {
+		SROW[r] = n;
+		PROW[r] = e;
+	      }
+	    for (k=2;k<sz;n++)
+	      {
+		id = SPANbulk(MAT(i,j,k));
+		for (k0=k;(k<sz) && (SPANbulk(MAT(i,j,k)) == id);k++)
+		  if (pecmask(MAT(i,j,k)) != 0)
+		    {
+		      if (pass == 1)
+			{
+			  PECS[e].k = k;
+			  PECS[e].mask = pecmask(MAT(i,j,k));
+			}
+		      e++;
+		    }
+		if (pass == 1)
+		  {
+		    SPANS[n].k0 = k0;
+		    SPANS[n].k1 = k;
+		    SPANS[n].id = id;
+		  }
+	      }
+	  }
+      if (pass == 0)
+	{
+	  SROW = (long *) malloc((r+1)*sizeof(long));
+	  SPANS = (Span *) malloc((n+1)*sizeof(Span));
+	  PROW = (long *) malloc((r+1)*sizeof(long));
+	  PECS = (Pec *) malloc((e+1)*sizeof(Pec));
+	}
+      else
+	{
+	  SROW[r] = n;
+	  PROW[r] = e;
+	}
+    }
+}
+
+void SPANfree()
+{
+  free(SROW);
+  free(SPANS);
+  free(PROW);
+  free(PECS);
+  SROW = NULL;
+  SPANS = NULL;
+  PROW = NULL;
+  PECS = NULL;
+}
+
+// Runs and cells of each class (PEC components are in the sparse list, not in runs)
+void SPANreport()
+{
+  static const char *name[SPAN_CLASSES] = {"vacuum", "dielectric", "PEC", "plasma"};
+  long n, rows = (long)(sx-2)*(sy-2), runs[SPAN_CLASSES] = {0}, cells[SPAN_CLASSES] = {0};
+  int c;
+
+  for (n=0;n<SROW[rows];n++)
+    {
+      c = SPANclass(SPANS[n].id);
+      runs[c]++;
+      cells[c] += SPANS[n].k1 - SPANS[n].k0;
+    }
+  printf("\tMaterial spans: %ld in %ld rows\n", SROW[rows], rows);
+  for (c=0;c<SPAN_CLASSES;c++)
+    if (runs[c] > 0)
+      printf("\t  %-10s %9ld spans %12ld cells\n", name[c], runs[c], cells[c]);
+  if (PROW[rows] > 0)
+    printf("\t  %-10s %9ld cells (zeroed after each E update)\n", name[SPAN_PEC], PROW[rows]);
+}
@@ -0,0 +1,103 @@
+#ifndef SPANS_H
+#define SPANS_H
+
+#include "../utils/types.h"
+
+extern int sx, sy, sz;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Material spans /
+///////////////////
+// After setup2 the material map no longer changes. Every interior (i,j) row (2..sx-1,
+// 2..sy-1) is cut into runs of cells (k 2..sz-1) with the same material byte, so a
+// kernel can take all its coefficients once per run and keep the inner loop free of
+// table loads and tests: the E update uses the broadcast kernel of the run's material,
+// Ecalcmod only sums the plasma current on plasma runs, Ucalc takes QF once per run.
+// Runs are stored row after row, SROW[r] is the first run of row r = (i-2)*(sy-2)+(j-2)
+// and SROW[r+1] the end. The class of a run (vacuum, dielectric, PEC, plasma) is only
+// used for the summary.
+//
+// PEC (antenna) components do not cut the runs: the runs are built on the bulk material
+// (SPANbulk, PEC classes read as vacuum) and the PEC cells go to a sparse list per row,
+// PROW/PECS like SROW/SPANS. The E walk updates the row as homogeneous media and then
+// sets the listed components back to 0, before anything reads them. This is what the
+// old CB = 0 update gave (E of a PEC component never leaves 0, sources assign E).
+
+#define SPAN_VACUUM 0
+#define SPAN_DIELECTRIC 1
+#define SPAN_PEC 2                              // At least one E component is PEC (antenna)
+#define SPAN_PLASMA 3                           // MAT_SIG
+#define SPAN_CLASSES 4
+
+struct Span
+{
+  int k0, k1;                                   // Cells [k0,k1) of the row
+  int id;                                       // Their material (MAT)
+};
+
+#define PEC_X 1                                 // PEC components of a listed cell
+#define PEC_Y 2
+#define PEC_Z 4
+
+struct Pec
+{
+  int k;                                        // Cell of the row
+  int mask;                                     // PEC_X | PEC_Y | PEC_Z
+};
+
+extern long *SROW;
+extern Span *SPANS;
+extern long *PROW;
+extern Pec *PECS;
+
+// Function Prototypes
+void SPANbuild();                               // After setup2
+void SPANfree();
+int SPANclass(int id);
+int SPANbulk(int id);                           // id with PEC components read as vacuum
+void SPANreport();
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Row r and k of the cell at offset c of the grid arrays (strides si, sj). Row segments
+// of the interior start below k = sz, so j*sj + k < si and k < sj.
+static inline long SPANrow(long c, long si, long sj, int &k)
+{
+  long i, j;
+
+  i = c / si;
+  j = (c - i*si) / sj;
+  k = (int)(c - i*si - j*sj);
+  return (i-2)*(sy-2) + (j-2);
+}
+
+// Calls run(a, c, n, id) for the part of the k row segment c0..c0+n-1 in each run, then
+// zeroes the PEC components of the segment in ex, ey, ez
+template <typename A>
+inline void SPANwalk(const A &a, long c0, long n, long si, long sj, void (*run)(const A &a, long c, long n, int id),
+		     ebreal *ex, ebreal *ey, ebreal *ez)
+{
+  int k0, ke, s0, s1;
+  long p, c, r = SPANrow(c0, si, sj, k0);
+
+  ke = k0 + (int)n;
+  for (p=SROW[r];(p<SROW[r+1]) && (SPANS[p].k0<ke);p++)
+    {
+      s0 = (SPANS[p].k0 > k0) ? SPANS[p].k0 : k0;
+      s1 = (SPANS[p].k1 < ke) ? SPANS[p].k1 : ke;
+      if (s1 > s0)
+	run(a, c0 + (s0-k0), s1-s0, SPANS[p].id);
+    }
+  for (p=PROW[r];(p<PROW[r+1]) && (PECS[p].k<ke);p++)
+    if (PECS[p].k >= k0)
+      {
+	c = c0 + (PECS[p].k-k0);
+	if (PECS[p].mask & PEC_X)
+	  ex[c] = 0.0;
+	if (PECS[p].mask & PEC_Y)
+	  ey[c] = 0.0;
+	if (PECS[p].mask & PEC_Z)
+	  ez[c] = 0.0;
+      }
+}
+
+#endif // SPANS_H
@@ -0,0 +1,231 @@
+#include "temporal.h"
+#include <math.h>
+#include <stdlib.h>
+#include "material.h"
+#include "field_calculator.h"
+#include "tiling.h"
+#include "../source/source.h"
+
+// Global variables from pffdtd.cpp (Externs)
+extern double dt, dx, dy, dz;
+extern int sx, sy, sz;
+extern EBField EX, EY, EZ;
+extern EBField BX, BY, BZ;
+extern int Snum;
+extern int **Sloc;
+extern double *VOLT, *CURRENT;
+
+// Mur boundary of a set of columns (Retard.h)
+void EBCcolumns(int i0, int i1, int j0, int j1);
+
+int TBLOCK = 0;
+int TBLOCK_W = 0;
+int FUSE = 1;
+int FUSE_W = 0;
+
+#define TBLOCK_BYTES (6*EB_BYTES+1)             // Cache resident per cell: E, B, MAT
+#define FUSE_BYTES (9*EB_BYTES+1)               // The same with the second B level
+
+void TEMPORALset(int steps, int width)
+{
+  TBLOCK = (steps > 1) ? steps : 0;
+  TBLOCK_W = (width > 0) ? width : 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// A tile grows by one column in i and j per step of the block, the (w+steps)^2 columns
+// of full k rows should fit half of L2. Never below steps+1 (see temporal.h).
+int TEMPORALwidth(int steps)
+{
+  int w = TBLOCK_W;
+
+  if (w == 0)
+    w = (int)sqrt((double)TILEcache() / 2 / ((double)sz*TBLOCK_BYTES)) - steps;
+  return (w < steps+1) ? steps+1 : w;
+}
+
+void FUSEDset(int on, int width)
+{
+  FUSE = (on != 0) ? 1 : 0;
+  FUSE_W = (width > 0) ? width : 0;
+}
+
+// Tiles of the fused step. Threaded, each tile is the whole i range and w j columns, the
+// w+1 j columns of one thread's slab of i (and the next i plane) should fit half of L2.
+// A single thread cuts i as well, (w+1)^2 columns should fit.
+int FUSEDwidth()
+{
+  int w = FUSE_W;
+  int slab = (sx-2 + SLAB_THREADS-1) / SLAB_THREADS + 1;
+  double cols = (double)TILEcache() / 2 / ((double)sz*FUSE_BYTES);
+
+  if (w == 0)
+    w = (SLAB_THREADS > 1) ? (int)(cols / slab) - 1 : (int)sqrt(cols) - 1;
+  return (w < 2) ? 2 : w;
+}
+
+// i width of the fused tiles
+int FUSEDiwidth()
+{
+  return (SLAB_THREADS > 1) ? sx-2 : FUSEDwidth();
+}
+
+// Tile bounds along one axis of s cells: b[0] = 2, b[p] = 2 + p*w while b[p] <= s-2,
+// the last tile ends at s. Returns the number of tiles.
+static int tilebounds(int s, int w, int *b)
+{
+  int p = 0;
+
+  b[0] = 2;
+  while (b[p] + w <= s - 2)
+    {
+      b[p+1] = b[p] + w;
+      p++;
+    }
+  b[p+1] = s;
+  return p + 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// One block of steps on tiles of width w. Tile (p,q) needs (p-1,q) and (p,q-1) done, and
+// the skewed tiles of one anti-diagonal p+q = d never read or write each other's cells
+// at any step of the block, so the diagonals are run in order with their tiles spread
+// over the threads (one region per block), every step of a tile by one thread. B is
+// updated in place (the second level is only needed by the plasma). volt is NULL when
+// Rcalc is left to the caller.
+static void blocks(int steps, int w, const double *tv, double *volt, double *current)
+{
+  int d, p, q, t, n, ni, nj, x, y;
+  int ia, ib, ja, jb, i0, i1, j0, j1;
+  int *bi, *bj;
+
+  bi = (int *) malloc((sx/w + 3)*sizeof(int));
+  bj = (int *) malloc((sy/w + 3)*sizeof(int));
+  ni = tilebounds(sx, w, bi);
+  nj = tilebounds(sy, w, bj);
+
+  SLAB_REGION(d, p, q, t, n, x, y, ia, ib, ja, jb, i0, i1, j0, j1)
+  for (d=0;d<ni+nj-1;d++)
+    {
+      SLAB_TILES
+      for (p=0;p<ni;p++)
+	{
+	  q = d - p;
+	  if ((q < 0) || (q >= nj))
+	    continue;
+	  for (t=0;t<steps;t++)
+	    {
+	      // Interior columns of this tile at step t (shifted back one per step)
+	      ia = (p == 0) ? 2 : bi[p] - t;
+	      ib = (p == ni-1) ? sx : bi[p+1] - t;
+	      ja = (q == 0) ? 2 : bj[q] - t;
+	      jb = (q == nj-1) ? sy : bj[q+1] - t;
+	      // The same with the boundary columns 1 and sx (sy) (inclusive)
+	      i0 = (ia == 2) ? 1 : ia;
+	      i1 = (ib == sx) ? sx : ib-1;
+	      j0 = (ja == 2) ? 1 : ja;
+	      j1 = (jb == sy) ? sy : jb-1;
+
+	      // E
+	      Erows(ia, ib, ja, jb);
+	      EBCcolumns(i0, i1, j0, j1);
+	      for (n=1;n<=Snum;n++)
+		if ((Sloc[n][0] >= i0) && (Sloc[n][0] <= i1) && (Sloc[n][1] >= j0) && (Sloc[n][1] <= j1))
+		  Esource(tv[t], n);
+	      // B
+	      Brows(ia, ib, ja, jb, 1);
+	      if (volt == NULL)
+		continue;
+	      // R, once B at x+1 and y+1 is done, that tile also holds the next E of x,y.
+	      // The cells it reads are in this tile or in (p-1,q), (p,q-1), (p-1,q-1)
+	      for (n=1;n<=Snum;n++)
+		{
+		  x = (Sloc[n][0]+1 < sx) ? Sloc[n][0]+1 : sx-1;
+		  y = (Sloc[n][1]+1 < sy) ? Sloc[n][1]+1 : sy-1;
+		  if ((x >= ia) && (x < ib) && (y >= ja) && (y < jb))
+		    {
+		      Rcalc(n);
+		      volt[t*(Snum+1)+n] = VOLT[n];
+		      current[t*(Snum+1)+n] = CURRENT[n];
+		    }
+		}
+	    }
+	}
+    }
+
+  free(bi);
+  free(bj);
+}
+
+void TEMPORALrun(int steps, const double *tv, double *volt, double *current)
+{
+  double start = TILEclock();
+
+  blocks(steps, TEMPORALwidth(steps), tv, volt, current);
+
+  TILEcount(KERNEL_TBLOCK, start, (double)steps*(sx-2)*(sy-2)*(sz-2)*(E_BYTES+B_BYTES));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// One fused step on tiles of wi x wj columns (j tiles outer, i tiles inner). One region
+// for the step: the i loop of every tile is shared, so with wi the whole i range (any
+// threaded run, see FUSEDiwidth) every thread updates its static slab of i (the slab it
+// first touched, SLAB_FOR) in every tile. E of a tile, then a barrier, Mur and the
+// sources of the tile by one thread (its end is a barrier), then B. B of a tile reads E
+// of the tile and of the ones before it only, and E of the next tile only the old B
+// level, so nothing waits between the B of one tile and the E of the next.
+static void fused(int wi, int wj, void (*erows)(int, int, int, int), double timev)
+{
+  int p, q, n, ni, nj, i, ia, ib, ja, jb, i0, i1, j0, j1;
+  int *bi, *bj;
+
+  bi = (int *) malloc((sx/wi + 3)*sizeof(int));
+  bj = (int *) malloc((sy/wj + 3)*sizeof(int));
+  ni = tilebounds(sx, wi, bi);
+  nj = tilebounds(sy, wj, bj);
+
+  SLAB_REGION(p, q, n, i, ia, ib, ja, jb, i0, i1, j0, j1)
+  for (q=0;q<nj;q++)
+    for (p=0;p<ni;p++)
+      {
+	ia = bi[p];
+	ib = bi[p+1];
+	ja = bj[q];
+	jb = bj[q+1];
+	i0 = (ia == 2) ? 1 : ia;
+	i1 = (ib == sx) ? sx : ib-1;
+	j0 = (ja == 2) ? 1 : ja;
+	j1 = (jb == sy) ? sy : jb-1;
+
+	// E
+	SLAB_SHARE
+	for (i=ia;i<ib;i++)
+	  erows(i, i+1, ja, jb);
+	SLAB_BARRIER
+	SLAB_SINGLE
+	{
+	  EBCcolumns(i0, i1, j0, j1);
+	  for (n=1;n<=Snum;n++)
+	    if ((Sloc[n][0] >= i0) && (Sloc[n][0] <= i1) && (Sloc[n][1] >= j0) && (Sloc[n][1] <= j1))
+	      Esource(timev, n);
+	}
+	// B
+	SLAB_SHARE
+	for (i=ia;i<ib;i++)
+	  Brows(i, i+1, ja, jb, 0);
+      }
+
+  free(bi);
+  free(bj);
+}
+
+void FUSEDstep(double timev, void (*erows)(int, int, int, int), int ebytes)
+{
+  double start = TILEclock();
+
+  // New B to the oldest level, E of every tile only reads the old one
+  fused(FUSEDiwidth(), FUSEDwidth(), erows, timev);
+  Bswap();
+
+  TILEcount(KERNEL_FUSED, start, (double)(sx-2)*(sy-2)*(sz-2)*(ebytes+B_BYTES));
+}
@@ -0,0 +1,53 @@
+#ifndef TEMPORAL_H
+#define TEMPORAL_H
+
+#include "../utils/types.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Temporal blocking /
+//////////////////////
+// Field only runs (no plasma) can advance E and B several steps inside one cache sized
+// tile before moving on, instead of streaming every field from memory twice a step.
+// The (i,j) columns are cut into skewed tiles: at step t of a block a tile covers
+// [b_p - t, b_p+1 - t) in i and likewise in j. E(i) needs B(i+1) of the step before and
+// B(i) needs E(i-1) of the same step, so with the tiles run in order every cell still
+// sees exactly the values it saw in the step by step loop (E and B are updated in place,
+// B has no second level here). Per tile and step the order of the loop is kept:
+// E, Mur (EBCcolumns on the tile's columns), sources, B, then Rcalc of the sources whose
+// reads are complete. The first and last tiles are kept at least block+1 wide so the Mur
+// faces always see their 3 history columns in the same tile.
+//
+// Threaded, the tiles of one anti-diagonal (p+q constant) run at the same time, each by
+// one thread for all steps of the block, with a barrier between diagonals. The thread
+// of a tile is not the one that first touched its pages (SLAB_FOR), and a grid of n x n
+// tiles keeps at most n threads busy.
+//
+// Results are bit for bit those of the step by step loop.
+//
+// Fused sweep: the same walk with one step per block replaces Ecalc/Ecalcmod, EBCcalc,
+// the sources and Bcalc of every step, plasma or not. B of a tile is updated right
+// after its E, while the E it reads (own, i-1, j-1 and k-1 neighbours) is still in
+// cache, instead of in a second full grid sweep. B keeps its two levels here (Pcalc
+// needs both) so E only ever reads the old B and the tiles need no skew. Threaded, the
+// tiles span the whole i range and the step is one parallel region: each thread takes
+// its static slab of i (SLAB_FOR) in every tile, with a barrier between E and B of a
+// tile. Rcalc and Pcalc still follow on the whole grid.
+
+extern int TBLOCK;                              // Steps per block (0/1 = step by step)
+extern int TBLOCK_W;                            // Tile width in i and j (0 = from L2)
+extern int FUSE;                                // Fused E/B sweep of single steps and fused U/N (--nofuse turns off)
+extern int FUSE_W;                              // Its tile width (0 = from L2)
+
+// Function Prototypes
+void TEMPORALset(int steps, int width);
+int TEMPORALwidth(int steps);                   // Tile width used for a block of steps
+// Runs steps (<= TBLOCK) time steps starting at times tv[0..steps-1], the voltage and
+// current of source a after step t go to volt/current[t*(Snum+1)+a]
+void TEMPORALrun(int steps, const double *tv, double *volt, double *current);
+void FUSEDset(int on, int width);
+int FUSEDwidth();                               // j width of its tiles
+int FUSEDiwidth();                              // i width (the whole range when threaded)
+// E (erows: Erows or Emodrows, ebytes per cell), Mur, sources at timev and B of one step
+void FUSEDstep(double timev, void (*erows)(int, int, int, int), int ebytes);
+
+#endif // TEMPORAL_H
@@ -0,0 +1,90 @@
+#include "tiling.h"
+#include "temporal.h"
+#include "../physics/plasma.h"
+#include <stdio.h>
+#include <chrono>
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#define TILE_L2 (1 << 20)                       // L2 per core when the OS does not report it
+
+int TILE_J = 0, TILE_K = 0;
+
+KernelStat KSTAT[KERNELS] = {
+  {"Ecalc", 0, 0.0, 0.0},
+  {"Bcalc", 0, 0.0, 0.0},
+  {"Ecalcmod", 0, 0.0, 0.0},
+  {"E+B block", 0, 0.0, 0.0},
+  {"E+B fused", 0, 0.0, 0.0},
+  {"Pcalc", 0, 0.0, 0.0},
+};
+
+void TILEset(int tj, int tk)
+{
+  TILE_J = (tj > 0) ? tj : 0;
+  TILE_K = (tk > 0) ? tk : 0;
+}
+
+// L2 bytes per core (TILE_L2 when the OS does not report it)
+long TILEcache()
+{
+  long l2 = 0;
+
+#ifdef _SC_LEVEL2_CACHE_SIZE
+  l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+  return (l2 > 0) ? l2 : TILE_L2;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Picks tiles so two i planes of one tile (bytes per cell) fit half of L2. k is kept
+// whole if at least 4 rows fit, long rows are what the vector kernels want; otherwise k
+// is cut to whole cache lines. Grids whose planes already fit are not tiled.
+void TILEauto(int bytes)
+{
+  long cells, nj = sy-2, nk = sz-2;
+
+  cells = TILEcache() / 2 / (2*(long)bytes);
+  TILE_J = TILE_K = 0;
+  if (nj*nk <= cells)
+    return;
+  if (4*nk <= cells)
+    TILE_J = (int)(cells / nk);
+  else
+    {
+      TILE_J = 4;
+      TILE_K = (int)(cells / 4 / 8 * 8);
+      if (TILE_K < 8)
+	TILE_K = 8;
+    }
+}
+
+double TILEclock()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TILEcount(int kernel, double start, double bytes)
+{
+  KSTAT[kernel].calls++;
+  KSTAT[kernel].seconds += TILEclock() - start;
+  KSTAT[kernel].bytes += bytes;
+}
+
+void TILEreport()
+{
+  int n;
+
+  printf("\tTiles j %d x k %d (0 = whole)\n", TILE_J, TILE_K);
+  if (KSTAT[KERNEL_TBLOCK].calls > 0)
+    printf("\tTemporal blocks of %d steps, tiles %d x %d (i x j)\n", TBLOCK, TEMPORALwidth(TBLOCK), TEMPORALwidth(TBLOCK));
+  if (KSTAT[KERNEL_FUSED].calls > 0)
+    printf("\tFused E/B sweep, tiles %d x %d (i x j)\n", FUSEDiwidth(), FUSEDwidth());
+  if ((KSTAT[KERNEL_PLASMA].calls > 0) && (FUSE == 1) && (PLASMA_COLD == 0))
+    printf("\tFused U/N sweep, %d bytes per cell instead of %d\n", UN_BYTES, U_BYTES+N_BYTES);
+  for (n=0;n<KERNELS;n++)
+    if (KSTAT[n].calls > 0)
+      printf("\t%-9s %6ld calls %8.2f s %7.2f GB/s\n", KSTAT[n].name, KSTAT[n].calls, KSTAT[n].seconds,
+	     (KSTAT[n].seconds > 0) ? KSTAT[n].bytes / KSTAT[n].seconds * 1e-9 : 0.0);
+}
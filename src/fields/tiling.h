@@ -0,0 +1,74 @@
+#ifndef TILING_H
+#define TILING_H
+
+#include "../utils/types.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Tiled traversal /
+////////////////////
+// The curl sweeps (Ecalc, Bcalc, Ecalcmod) read the i+1 (or i-1) plane of the cell they
+// update. Walking whole (j,k) planes one i at a time, that plane has left L2 by the time
+// it is reused on large grids. TILEsweep cuts the interior (2..sx-1, 2..sy-1, 2..sz-1)
+// into TILE_J x TILE_K columns and runs each column over all i, so two planes of one
+// column stay in cache. Every k row segment of a column goes to the row function.
+//
+// Every cell is updated exactly as before, only the order changes (the sweeps do not
+// read what they write), so the results do not depend on the tile size.
+
+extern int sx, sy, sz;
+extern int TILE_J, TILE_K;                      // Tile size in j and k (0 = whole extent)
+
+// Per kernel timing, bytes are the compulsory traffic of the kernel (see *_BYTES)
+#define KERNEL_E 0
+#define KERNEL_B 1
+#define KERNEL_EMOD 2
+#define KERNEL_TBLOCK 3                         // Temporal blocks (temporal.h), bytes of the steps they replace
+#define KERNEL_FUSED 4                          // Fused E/B sweeps (temporal.h), bytes of the sweeps they replace
+#define KERNEL_PLASMA 5                         // Pcalc, bytes of the separate Ucalc and Ncalc sweeps
+#define KERNELS 6
+
+#define E_BYTES (9*EB_BYTES+1)                  // Ecalc per cell: E read+write, B read, MAT
+#define B_BYTES (9*EB_BYTES)                    // Bcalc per cell: B and E read, new B written
+
+struct KernelStat
+{
+  const char *name;
+  long calls;
+  double seconds;
+  double bytes;
+};
+
+extern KernelStat KSTAT[KERNELS];
+
+// Function Prototypes
+void TILEset(int tj, int tk);
+void TILEauto(int bytes);                       // Sizes the tiles for kernels moving bytes per cell
+long TILEcache();                               // L2 bytes per core
+double TILEclock();                             // Wall clock (s)
+void TILEcount(int kernel, double start, double bytes);
+void TILEreport();                              // Prints time and bandwidth of each kernel
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Calls row(a, c, n) for every k row segment of the interior, tile by tile. F gives the
+// grid shape (all grid arrays share it). In OpenMP builds every thread keeps its static
+// slab of i in all tiles (see SLAB_SHARE) so the first touch placement is kept.
+template <typename A, typename T>
+void TILEsweep(const FieldT<T> &F, void (*row)(const A &a, long c, long n), const A &a)
+{
+  int i, j, jb, kb, je, ke;
+  const int tj = (TILE_J > 0) ? TILE_J : sy, tk = (TILE_K > 0) ? TILE_K : sz;
+
+  SLAB_REGION(i, j, jb, kb, je, ke)
+  for (jb=2;jb<sy;jb+=tj)
+    for (kb=2;kb<sz;kb+=tk)
+      {
+	je = (jb+tj < sy) ? jb+tj : sy;
+	ke = (kb+tk < sz) ? kb+tk : sz;
+	SLAB_SHARE
+	for (i=2;i<sx;i++)
+	  for (j=jb;j<je;j++)
+	    row(a, F.index(i,j,kb), ke-kb);
+      }
+}
+
+#endif // TILING_H
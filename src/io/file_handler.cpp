@@ -7,6 +7,8 @@
 #include "../utils/memallocate.h" // For darray/iarray/EMBCallocate etc
 #include "output.h" // For headvc, headfd
 #include "../physics/plasma.h" // For plasma globals if needed in setup2/ClearArrays
+#include "../fields/material.h" // Material map (1/Er, QF, SIG)
+#include "../fields/field_kernels.h" // Cubic cell kernels (FIELDuniform)
 
 // Extern globals from pffdtd.cpp
 extern int sx, sy, sz;
@@ -17,21 +19,20 @@ extern int **Sloc;
 extern double *Spar;
 extern int plasma;
 extern int fields;
+extern int uniform;
 extern int frate;
 extern int fout[6];
 extern int floc[2][3];
-extern double ****EX, ****EY, ****EZ;
-extern double ****BX, ****BY, ****BZ;
-extern double ***ERX, ***ERY, ***ERZ;
+extern EBField EX, EY, EZ;
+extern EBField BX, BY, BZ;
+extern EBField BXP, BYP, BZP;
 extern double *VOLT, *CURRENT;
-extern double ***QF, ***SIG; // From plasma?
 extern double Charge;
 // Need constants C, MU_0, EPSILON_0?
 
 // Forward declarations if not in headers
-extern int EMBCallocate(int);
+extern void EMBCallocate();
 extern void EMBCclear();
-extern void EMBCfree();
 // PLASMAallocate is in plasma.h which is included
 
 FILE *openfile(char filepre[81], char filesuf[3])
@@ -92,6 +93,10 @@ int setup1(FILE *fp1)
   printf("\tdx=%5.3f\tdy=%5.3f\tdz=%5.3f\n",dx,dy,dz);
   dt=dx/(2*C);                         // Time iteration
   printf("\tdt = %e\n",dt);
+  // Equal spacing selects the cubic cell forms of the kernels (field_kernels.h)
+  FIELDuniform((uniform == 1) && (dx == dy) && (dy == dz));
+  if (FIELD_UNIFORM)
+    printf("\tCubic cells (folded kernels)\n");
   // Fail Safe Parameters
   if (fgets(tp1,80,fp1)==NULL)
     return 1;
@@ -115,13 +120,110 @@ int setup1(FILE *fp1)
   return 0;
 }
 
+// Species of a plasma run from the optional file filepre.sp, one species per line:
+//	mass(kg)	charge(e)	population
+// electrons (charge -1) first, lines starting with / are comments. Without the file the
+// built in electrons, O+ and NO+ are used. n > 0 keeps only the first n species (an
+// error if there are fewer).
+int setupspecies(char filepre[81], int n)
+{
+  char temp[81], tp1[80];
+  FILE *fp;
+  int a, b;
+  double *mass, *charge, *pop;
+
+  strcpy(temp, filepre);
+  strcat(temp, ".sp");
+  if ((fp = fopen(temp,"r")) == NULL)
+    return PLASMAspecies((n > 0) ? n : 3, NULL, NULL, NULL);
+  printf("SPECIES FILE: %s\n", temp);
+  // Count, then read
+  b = 0;
+  while (fgets(tp1,80,fp) != NULL)
+    if ((tp1[0] != '/') && (strspn(tp1, " \t\r\n") < strlen(tp1)))
+      b++;
+  if (b == 0)
+    {
+      fclose(fp);
+      printf("No species in %s\n", temp);
+      return 1;
+    }
+  mass = darray1(0, b-1);
+  charge = darray1(0, b-1);
+  pop = darray1(0, b-1);
+  rewind(fp);
+  a = 0;
+  while ((a < b) && (fgets(tp1,80,fp) != NULL))
+    {
+      if ((tp1[0] == '/') || (strspn(tp1, " \t\r\n") == strlen(tp1)))
+	continue;
+      if (sscanf(tp1,"%lf %lf %lf",&mass[a],&charge[a],&pop[a]) != 3)
+	{
+	  printf("Bad species line: %s", tp1);
+	  break;
+	}
+      a++;
+    }
+  fclose(fp);
+  // One exit for the bad line, too many species asked for and the species themselves
+  if (a < b)
+    a = 1;
+  else if (n > b)
+    {
+      printf("Only %d species in %s\n", b, temp);
+      a = 1;
+    }
+  else
+    a = PLASMAspecies((n > 0) ? n : b, mass, charge, pop);
+  freedarray1(mass, 0, b-1);
+  freedarray1(charge, 0, b-1);
+  freedarray1(pop, 0, b-1);
+  return a;
+}
+
+// Reads ahead to the field output line that setup2 reads later and returns 1 if it asks
+// for the electron or ion density, 0 if not (or if there is no field output), -1 if the
+// file ends early or a line does not parse. Needed before the arrays are allocated, as a
+// cold plasma only keeps N for the output (PLASMAcold). The file position is left as it
+// was. The lines skipped here are those of setup2, the two must be kept in step.
+int setupdensity(FILE *fp1)
+{
+  char tp1[80];
+  int a, b, d, f[7];
+  long pos = ftell(fp1);
+
+  f[4] = f[6] = 0;
+  // Sources, dielectric header and 2 Er lines, antenna header and cell count
+  for (a=1;(a<=Snum+5)&&(fgets(tp1,80,fp1)!=NULL);a++)
+    ;
+  if ((a <= Snum+5) || (sscanf(tp1,"%d",&b) != 1))
+    d = -1;
+  else
+    {
+      // Antenna cells, then the optional output header and line
+      for (a=1;(a<=b)&&(fgets(tp1,80,fp1)!=NULL);a++)
+	;
+      if (a <= b)
+	d = -1;
+      else if (fgets(tp1,80,fp1) == NULL)
+	d = 0;
+      else if ((fgets(tp1,80,fp1) == NULL) ||
+	       (sscanf(tp1,"%d\t%d\t%d\t%d\t%d\t%d\t%d",&f[0],&f[1],&f[2],&f[3],&f[4],&f[5],&f[6]) < 2))
+	d = -1;
+      else
+	d = ((f[4] == 1) || ((f[6] == 1) && (NS > 1))) ? 1 : 0;
+    }
+  fseek(fp1, pos, SEEK_SET);
+  return d;
+}
+
 int setup2(FILE *fp1)
 {
   char tp1[80];
   char tp2[10];
   int a,b;
   int i,j,k,l,m,n;
-  double ER[2];
+  double ER[2], SG[2];
 
   // Source Parameters part 2
   for (a=1;a<=Snum;a++)
@@ -141,12 +243,24 @@ int setup2(FILE *fp1)
   printf("\t%s",tp1);
    if (fgets(tp1,80,fp1)==NULL)
     return 1;
-  ER[0] = atof(tp1);
-  printf("\tEr 1 = %5.3f\n",ER[0]);
+  // Er, optionally followed by the conductivity (S/m) of a lossy dielectric
+  SG[0] = 0;
+  if (sscanf(tp1,"%lf %lf",&ER[0],&SG[0]) < 1)
+    return 1;
+  printf("\tEr 1 = %5.3f",ER[0]);
+  if (SG[0] != 0)
+    printf(" sigma = %e S/m",SG[0]);
+  printf("\n");
   if (fgets(tp1,80,fp1)==NULL)
     return 1;
-  ER[1] = atof(tp1);
-  printf("\tEr 2 = %5.3f\n",ER[1]);
+  SG[1] = 0;
+  if (sscanf(tp1,"%lf %lf",&ER[1],&SG[1]) < 1)
+    return 1;
+  printf("\tEr 2 = %5.3f",ER[1]);
+  if (SG[1] != 0)
+    printf(" sigma = %e S/m",SG[1]);
+  printf("\n");
+  MATtables(ER[0], ER[1], Charge, SG[0], SG[1]);
   // Antenna Parameters
   if (fgets(tp1,80,fp1)==NULL)
     return 1;
@@ -162,63 +276,63 @@ int setup2(FILE *fp1)
       switch (l)
 	{
 	case 1:
-          ERX[i][j][k] = 0;
+          MATsetclass(i, j, k, MAT_SHX, MAT_PEC);
 	  if (plasma == 1)
-	      QF[i][j][k] = Charge;
+	      MAT(i,j,k) |= MAT_QF;
           break;
         case 2:
-	  ERX[i][j][k] = 1/ER[0];
+	  MATsetclass(i, j, k, MAT_SHX, MAT_ER1);
 	  break;
         case 3:
-	  ERX[i][j][k] = 1/ER[1];
+	  MATsetclass(i, j, k, MAT_SHX, MAT_ER2);
           break;
         default:
-	  ERX[i][j][k] = 1;
+	  MATsetclass(i, j, k, MAT_SHX, MAT_VACUUM);
 	  break;
 	}
       switch (m)
 	{
 	case 1:
-          ERY[i][j][k] = 0;
+          MATsetclass(i, j, k, MAT_SHY, MAT_PEC);
 	  if (plasma == 1)
-	      QF[i][j][k] = Charge;
+	      MAT(i,j,k) |= MAT_QF;
           break;
         case 2:
-	  ERY[i][j][k] = 1/ER[0];
+	  MATsetclass(i, j, k, MAT_SHY, MAT_ER1);
 	  break;
         case 3:
-	  ERY[i][j][k] = 1/ER[1];
+	  MATsetclass(i, j, k, MAT_SHY, MAT_ER2);
           break;
         default:
-	  ERY[i][j][k] = 1;
+	  MATsetclass(i, j, k, MAT_SHY, MAT_VACUUM);
 	  break;
 	}
       switch (n)
 	{
 	case 1:
-          ERZ[i][j][k] = 0;
+          MATsetclass(i, j, k, MAT_SHZ, MAT_PEC);
 	  if (plasma == 1)
-	      QF[i][j][k] = Charge;
+	      MAT(i,j,k) |= MAT_QF;
           break;
         case 2:
-	  ERZ[i][j][k] = 1/ER[0];
+	  MATsetclass(i, j, k, MAT_SHZ, MAT_ER1);
 	  break;
         case 3:
-	  ERZ[i][j][k] = 1/ER[1];
+	  MATsetclass(i, j, k, MAT_SHZ, MAT_ER2);
           break;
         default:
-	  ERZ[i][j][k] = 1;
+	  MATsetclass(i, j, k, MAT_SHZ, MAT_VACUUM);
 	  break;
 	}
       if ((plasma ==1) & (l>1) & (m>1) & (n>1))
-	SIG[i][j][k] = 0;                             // Turns off Plasma inside dielectrics
+	MAT(i,j,k) &= ~MAT_SIG;                     // Turns off Plasma inside dielectrics
       if ( (a==1) | (a==b) )
-	printf("\t(%d,%d,%d) 1/Erx->%5.3f 1/Ery->%5.3f 1/Erz->%5.3f \n",i,j,k,ERX[i][j][k],ERY[i][j][k],ERZ[i][j][k]);
+	printf("\t(%d,%d,%d) 1/Erx->%5.3f 1/Ery->%5.3f 1/Erz->%5.3f \n",i,j,k,MATERX[MAT(i,j,k)],MATERY[MAT(i,j,k)],MATERZ[MAT(i,j,k)]);
       if ( (a==2) & (a!=b) )
 	printf("\t\t.\n\t\t.\n\t\t.\n");
 
     }
-  // Points of Field output (opt.)
+  // Points of Field output (opt.), setupdensity reads ahead to this line
   if (fgets(tp1,80,fp1)==NULL)
     return 0;
   fields = 1;                                         // Turns field output on
@@ -226,6 +340,8 @@ int setup2(FILE *fp1)
   fgets(tp1,80,fp1);
   if (sscanf(tp1,"%d\t%d\t%d\t%d\t%d\t%d\t%d",&frate,&fout[0],&fout[1],&fout[2],&fout[3],&fout[4],&fout[5])<2)
     return 1;
+  if ((plasma == 1) && (NS == 1))
+    fout[4] = fout[5] = 0;                            // Electrons only, no ion output
   printf("\tOutput ->");
   if (fout[0]==1)
     printf(" Electric");
@@ -254,25 +370,25 @@ int setup2(FILE *fp1)
 
 void ClearArrays()
 {
-  int i, j, k, l;
+  int i, j, k;
 
+  // Same slabs as the kernels (first touch)
+  SLAB_FOR(j, k)
   for (i=1;i<=sx;i++)
     for (j=1;j<=sy;j++)
       for (k=1;k<=sz;k++)
 	{
-	  for (l=0;l<=1;l++)
-	    {
-	      EX[i][j][k][l] = 0;
-	      EY[i][j][k][l] = 0;
-	      EZ[i][j][k][l] = 0;
-	      BX[i][j][k][l] = 0;
-	      BY[i][j][k][l] = 0;
-	      BZ[i][j][k][l] = 0;
-	    }
-	  ERX[i][j][k] = 1;
-	  ERY[i][j][k] = 1;
-	  ERZ[i][j][k] = 1;
+	  EX(i,j,k) = 0;
+	  EY(i,j,k) = 0;
+	  EZ(i,j,k) = 0;
+	  BX(i,j,k) = 0;
+	  BY(i,j,k) = 0;
+	  BZ(i,j,k) = 0;
+	  BXP(i,j,k) = 0;
+	  BYP(i,j,k) = 0;
+	  BZP(i,j,k) = 0;
 	}
+  MATclear();
 
   for (j=1;j<=Snum;j++)
   {
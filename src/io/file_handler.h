@@ -10,6 +10,8 @@ FILE *openfile2(char filepre[81], char filesuf[3]);
 // Setup / Import
 int setup1(FILE *fp1);
 int setup2(FILE *fp1);
+int setupdensity(FILE *fp1);                    // 1 if the field output writes a density, -1 on a bad file (read ahead of setup2)
+int setupspecies(char filepre[81], int n);      // Species table from filepre.sp (built in without one)
 
 // Utility
 void ClearArrays();
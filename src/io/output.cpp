@@ -13,8 +13,8 @@ extern int fout[6];
 extern int plasma; 
 
 // Field arrays
-extern double ****EX, ****EY, ****EZ;
-extern double ****BX, ****BY, ****BZ;
+extern EBField EX, EY, EZ;
+extern EBField BX, BY, BZ;
 // UX, UY, UZ, N, N_0 are defined in plasma.h
 
 void headvc(FILE *file_vc)
@@ -142,19 +142,19 @@ void outputfd(FILE *file_fd, int a, double timev)
       for (k = floc[0][2]; k <= floc[1][2]; k++)
 	{
 	  if (fout[0] == 1)
-	    fprintf(file_fd,"\t%e\t%e\t%e",EX[i][j][k][1], EY[i][j][k][1], EZ[i][j][k][1]);
+	    fprintf(file_fd,"\t%e\t%e\t%e",EX(i,j,k), EY(i,j,k), EZ(i,j,k));
 	  if (fout[1] == 1)
-	    fprintf(file_fd,"\t%e\t%e\t%e",BX[i][j][k][1], BY[i][j][k][1], BZ[i][j][k][1]);
+	    fprintf(file_fd,"\t%e\t%e\t%e",BX(i,j,k), BY(i,j,k), BZ(i,j,k));
 	  if (plasma == 1)
 	    {
 	      if (fout[2] == 1)
-		fprintf(file_fd,"\t%e\t%e\t%e",UX[i][j][k][1][0], UY[i][j][k][1][0], UZ[i][j][k][1][0]);
+		fprintf(file_fd,"\t%e\t%e\t%e",UX[0][1](i,j,k), UY[0][1](i,j,k), UZ[0][1](i,j,k));
 	      if (fout[3]== 1)
-		fprintf(file_fd,"\t%e",(N[i][j][k][1][0]-N_0[0]));
+		fprintf(file_fd,"\t%e",(N[0][1](i,j,k)-N_0[0]));
 	      if (fout[4] == 1)
-	      	fprintf(file_fd,"\t%e\t%e\t%e",UX[i][j][k][1][1], UY[i][j][k][1][1], UZ[i][j][k][1][1]);
+	      	fprintf(file_fd,"\t%e\t%e\t%e",UX[1][1](i,j,k), UY[1][1](i,j,k), UZ[1][1](i,j,k));
 	      if (fout[5]== 1)
-	      	fprintf(file_fd,"\t%e",(N[i][j][k][1][1]-N_0[1]));
+	      	fprintf(file_fd,"\t%e",(N[1][1](i,j,k)-N_0[1]));
 	    }
 	}
 		
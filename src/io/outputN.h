@@ -148,12 +148,12 @@ void outputfd(FILE *file_fd, int a, double timev)
 		fprintf(file_fd,"\t%e\t%e\t%e",UX[i][j][k][1][0], UY[i][j][k][1][0], UZ[i][j][k][1][0]);
 	      if (fout[3]== 1)
 		//fprintf(file_fd,"\t%e",(N[i][j][k][1][0]-N_0[0]));// Uncomment this line and comment the one below to restore jeff's code.
-                fprintf(file_fd,"\t%e",N_0[i][j][k][1][0]);//Write only ambient density values
-		//printf("N0=%f,i=%d,j=%d,k=%d\n",N_0[i][j][k][0][0],i,j,k);
+                fprintf(file_fd,"\t%e",N_0[i][j][k]*NPOP[0]);//Write only ambient density values
+		//printf("N0=%f,i=%d,j=%d,k=%d\n",N_0[i][j][k],i,j,k);
 	      if (fout[4] == 1)
 	      	fprintf(file_fd,"\t%e\t%e\t%e",UX[i][j][k][1][1], UY[i][j][k][1][1], UZ[i][j][k][1][1]);
 	      //if (fout[5]== 1)
-	      	//fprintf(file_fd,"\t%e",(N[i][j][k][1][1]-N_0[i][j][k][1][0]));
+	      	//fprintf(file_fd,"\t%e",(N[i][j][k][1][1]-N_0[i][j][k]*NPOP[0]));
  		//fprintf(file_fd,"\t%e",(N[i][j][k][1][1]-N_0[1]));
 
 	    }
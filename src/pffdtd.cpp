@@ -57,6 +57,9 @@
 #include "signal.h"
 //#include "malloc.h"
 
+// Flat field container (Field)
+#include "utils/types.h"
+
 // Constants
 // Moved to utils/constants.h
 
@@ -65,10 +68,12 @@
 int Q_flag;				// Flag to quit
 int plasma;				// Flags (1 = present, 0 = not present)
 int fields;                             // Flags (1 = output fields, 0 = no output)
+int dryrun;                             // Flags (1 = only print the memory plan (--dry-run), 0 = run)
+int uniform;                            // Flags (1 = cubic cell kernels when dx = dy = dz, 0 = general (--nouniform))
 // Define pointers to field values
-double ****EX, ****EY, ****EZ;		// Electric Field
-double ****BX, ****BY, ****BZ;		// Magntic Desplacement
-double ***ERX, ***ERY, ***ERZ;		// 1/Relitive Pervitvity
+EBField EX, EY, EZ;			// Electric Field
+EBField BX, BY, BZ;			// Magntic Desplacement
+EBField BXP, BYP, BZP;			// Magntic Desplacement at the previous time step (swapped with BX.. by Bcalc)
 // Grid difinitions
 int sx, sy, sz;				// Grid Size
 double dx, dy, dz, dt, df;		// Grid Spacing
@@ -96,6 +101,10 @@ int PLASMA_CYCLE;			// Number of plasma oscilations the simulation will run for.
 // Constants (Must be first)
 // Exit routine
 void ctrlc_handler(int);
+// Carves the simulation arrays out of the arena
+void Allocate();
+// Prints the memory plan against available memory (--dry-run)
+int DryRun();
 
 /*****************************************************************************/
 // Constants (Must be first)
@@ -109,6 +118,11 @@ void ctrlc_handler(int);
 
 // Fields
 #include "fields/field_calculator.h"
+#include "fields/material.h"
+#include "fields/field_kernels.h"
+#include "fields/tiling.h"
+#include "fields/temporal.h"
+#include "fields/spans.h"
 
 // Plasma routines
 // If included set plasma = 1 in main
@@ -136,9 +150,20 @@ int main(int argc, char*argv[])
   FILE *file_vc, *file_fd;	        // Output files
   double timev;				// Time variable
   time_t tstart, tstop;                 // Program Starting and Stopping times
+  clock_t cstart, cstop;                // Processor time spent in the time loop
+  double rate;                          // Cell updates per second
   int trem;                             // Used to calculate run time
   int i, ip, j, m;			// Iteration
-  int size, allocate=0;			// allocated data size
+  int isa;				// E/B kernel instruction set (--isa=, default best of this CPU)
+  int tj, tk;				// Tile size (--tile=JxK, default -1 -> sized from L2)
+  int tn, tw;				// Temporal blocks (--tblock=steps[xwidth], field only runs)
+  int fu, fw;				// Fused E/B sweep (--nofuse, --fuse=width)
+  int cold;				// Cold, drift free plasma kernels when T = 0 and no drift (--nocold)
+  int ns;				// Species of the table used (--species=n, 0 = all)
+  int d;				// Field output writes a density (setupdensity)
+  int n, s;				// Steps of one pass through the loop
+  double *tv, *tvolt, *tcurrent;	// Times and source results of the steps of a temporal block
+  unsigned long long allocate;		// allocated data size (bytes, exact)
   
   //Defaults
   FAIL_SAFE=10;        			// Fail Safe (Program will stop at iteration ###)
@@ -148,6 +173,15 @@ int main(int argc, char*argv[])
   plasma = 1;
   fields = 0;
   frate = FAIL_SAFE;
+  dryrun = 0;
+  uniform = 1;
+  isa = FIELDcpu();
+  tj = tk = -1;
+  tn = tw = 0;
+  fu = 1;
+  fw = 0;
+  cold = 1;
+  ns = 0;
 
   // Welcome
   time(&tstart);
@@ -161,6 +195,43 @@ int main(int argc, char*argv[])
   printf("=======================================================\n");
   printf("\n");
 
+  // Options (taken out of the positional arguments)
+  for (i=1,j=1;i<argc;i++)
+    if (strcmp(argv[i],"--dry-run") == 0)
+      dryrun = 1;
+    else if (strncmp(argv[i],"--isa=",6) == 0)
+      isa = FIELDisa(argv[i]+6);
+    else if (strncmp(argv[i],"--tile=",7) == 0)
+      sscanf(argv[i]+7, "%dx%d", &tj, &tk);
+    else if (strncmp(argv[i],"--tblock=",9) == 0)
+      sscanf(argv[i]+9, "%dx%d", &tn, &tw);
+    else if (strcmp(argv[i],"--nofuse") == 0)
+      fu = 0;
+    else if (strncmp(argv[i],"--fuse=",7) == 0)
+      fw = atoi(argv[i]+7);
+    else if (strcmp(argv[i],"--nouniform") == 0)
+      uniform = 0;
+    else if (strncmp(argv[i],"--drift=",8) == 0)
+      sscanf(argv[i]+8, "%lf,%lf,%lf", &UX_0, &UY_0, &UZ_0);
+    else if (strcmp(argv[i],"--nocold") == 0)
+      cold = 0;
+    else if (strncmp(argv[i],"--species=",10) == 0)
+      ns = atoi(argv[i]+10);
+    else if (strcmp(argv[i],"--vacuum") == 0)
+      plasma = -1;                              // Field only run, kept over the plasma arguments below
+    else
+      argv[j++] = argv[i];
+  argc = j;
+
+  // Vector kernels for the E/B updates
+  if (FIELDselect(isa) == 1)
+    {
+      printf("Kernels %s not supported on this CPU (best is %s)\n",
+	     (isa < 0) ? "requested" : FIELDname(isa), FIELDname(FIELDcpu()));
+      return 1;
+    }
+  printf("FIELD KERNELS: %s\n", FIELDname(isa));
+
   // Get Input File
   if (argc > 1)
     {
@@ -172,7 +243,8 @@ int main(int argc, char*argv[])
 	}
       if (argc > 3)
 	{
-	  plasma = 1;
+	  if (plasma != -1)
+	    plasma = 1;
 	  FREQ_PLASMA = atof(argv[3]);
 	}
       else
@@ -196,12 +268,20 @@ int main(int argc, char*argv[])
       scanf(" %s",&fileout);
     }
 
+  if (plasma == -1)
+    plasma = 0;
+
   // Open DATA FILE - Error at this point returns a 1
   printf("OPENING DATA FILES \n"
   );
   file_str = openfile2(filein,".str");
-  file_vc = openfile(fileout,".vc");		// Voltage / Current @ feed
-  file_fd = openfile(fileout,".fd");		// Field Values
+  if (dryrun == 1)
+    file_vc = file_fd = NULL;                   // Nothing is written on a dry run
+  else
+    {
+      file_vc = openfile(fileout,".vc");	// Voltage / Current @ feed
+      file_fd = openfile(fileout,".fd");	// Field Values
+    }
 
   // Set up Arrays
   printf("INSALIZING ARRAYS \n");
@@ -211,29 +291,64 @@ int main(int argc, char*argv[])
       printf("Error Reading %s.str file format\n",filein);
       exit(3);
     }
-  // Allocate arrays
-  size = sx*sy*sz*sizeof(double) + sx*sy*sizeof(double) + sx*sizeof(double) + sizeof(double);
-  EX = darray4(1, sx, 1, sy, 1, sz, 0, 1);
-  EY = darray4(1, sx, 1, sy, 1, sz, 0, 1);
-  EZ = darray4(1, sx, 1, sy, 1, sz, 0, 1);
-  allocate = allocate + 3*(size + 2*sx*sy*sz*sizeof(double));
-  allocate = EMBCallocate(allocate);
-  BX = darray4(1, sx, 1, sy, 1, sz, 0, 1);
-  BY = darray4(1, sx, 1, sy, 1, sz, 0, 1);
-  BZ = darray4(1, sx, 1, sy, 1, sz, 0, 1);
-  allocate = allocate + 3*(size + 2*sx*sy*sz*sizeof(double));
-  ERX = darray3(1, sx, 1, sy, 1, sz);
-  ERY = darray3(1, sx, 1, sy, 1, sz);
-  ERZ = darray3(1, sx, 1, sy, 1, sz);
-  allocate = allocate + 3*size;
+  // Before anything is allocated: the species (filein.sp or built in) and whether a cold
+  // plasma needs N for the output (plasma.h)
+  if (plasma == 1)
+    {
+      if (setupspecies(filein, ns) == 1)
+	{
+	  printf("Error in the species of %s\n",filein);
+	  exit(3);
+	}
+      if ((d = setupdensity(file_str)) < 0)
+	{
+	  printf("Error Reading %s.str file format\n",filein);
+	  exit(3);
+	}
+      PLASMAcold(cold, d);
+    }
+  if (dryrun == 1)
+    {
+      fclose(file_str);
+      return DryRun();
+    }
+  // Tiles of the curl sweeps (tiling.h)
+  if (tj < 0)
+    TILEauto(EMOD_BYTES);
+  else
+    TILEset(tj, (tk < 0) ? 0 : tk);
+  // Temporal blocks (temporal.h), the plasma couples more than the E/B neighbours a
+  // block is skewed for, so they are only used on field only runs (--vacuum)
+  if ((tn > 1) && (plasma == 1))
+    {
+      printf("Temporal blocks need --vacuum, running step by step\n");
+      tn = 0;
+    }
+#ifdef FIELD_FLOAT
+  printf("E/B FIELDS: float storage, double arithmetic\n");
+#endif
+  TEMPORALset(tn, tw);
+  FUSEDset(fu, fw);
+  if (fu == 1)
+    printf("FUSED E/B SWEEP: tiles %d x %d (i x j)\n", FUSEDiwidth(), FUSEDwidth());
+  tv = tvolt = tcurrent = NULL;
+  if (tn > 1)
+    {
+      printf("TEMPORAL BLOCKS: %d steps, tiles %d x %d (i x j)\n", tn, TEMPORALwidth(tn), TEMPORALwidth(tn));
+      tv = darray1(0, tn-1);
+      tvolt = darray1(0, tn*(Snum+1)-1);
+      tcurrent = darray1(0, tn*(Snum+1)-1);
+    }
+  // Allocate arrays (planning pass to size the arena, then carve)
+  arenaplan();
+  Allocate();
+  allocate = arenareserve();
+  Allocate();
+  arenareport();
   Sloc = iarray2(1, Snum, 0, 5);
-  allocate = allocate + Snum*6*sizeof(double) + 6*sizeof(double); 
   Spar = darray1(1, Snum);
   VOLT = darray1(1, Snum);
   CURRENT = darray1(1, Snum);
-  allocate = allocate + 3*Snum*sizeof(double); 
-  if (plasma == 1)
-    allocate = PLASMAallocate(allocate);
     	
   //Clear Arrays
   ClearArrays();
@@ -256,9 +371,16 @@ int main(int argc, char*argv[])
     {
       printf("\t\\\\Plasma Parameters\n\tfp->%5.3f(MHz)\tfc->%5.3f(MHz)\tfg->%5.3f(MHz)\n\t@%5.3f elivation & %5.3f azmith\n",(FREQ_PLASMA/1e6),(FREQ_PLASMA*FREQ_COL/1e6),(FREQ_CYC/1e6),ANGLE_E_CYC,ANGLE_A_CYC);
       df = dt*FREQ_PLASMA; 
-      printf("\t N_0 -> %5.3f, %5.3f, %5.3f 1/cc\n",N_0[0]*1e-6,N_0[1]*1e-6,N_0[2]*1e-6);
+      printf("\t N_0 ->");
+      for (m=0;m<NS;m++)
+	printf("%s %5.3f", (m > 0) ? "," : "", N_0[m]*1e-6);
+      printf(" 1/cc\n");
     }
 
+  // Material runs of every row for the E and plasma kernels (spans.h)
+  SPANbuild();
+  SPANreport();
+
   // Write header line for output files
   headvc(file_vc);
   headfd(file_fd);
@@ -277,59 +399,99 @@ int main(int argc, char*argv[])
   timev = 0.0;
   i = 1;
   ip = 1000000000;
+  cstart = clock();
 
   // Note: C_flag < # is set so that false convergance are overlooked
   while ( Q_flag == 0 )
     {
-      // Calculate Fields	(Finite Difference Part)
-      // E
-      if (plasma == 1)
-	Ecalcmod();
+      // Steps of this pass: one, or a temporal block for field only runs (temporal.h).
+      // A block ends on a step where the loop would stop or write the fields.
+      n = 1;
+      if (tn > 1)
+	{
+	  tv[0] = timev;
+	  while ((n < tn) && !((((i+n-1)*df) > PLASMA_CYCLE) || (i+n-1 >= FAIL_SAFE)
+				|| (((i+n-2)%frate==0) & (fields==1))))
+	    {
+	      tv[n] = tv[n-1] + dt;
+	      n++;
+	    }
+	}
+
+      if (n > 1)
+	TEMPORALrun(n, tv, tvolt, tcurrent);
       else
-	Ecalc();
-      EBCcalc();
-      for (j=1;j<=Snum;j++)
-	Esource(timev,j);
-      // B
-      Bcalc();
-      // Plasma
-      if (plasma == 1) //& ((ip*df*1e3) >= 1))
-      {
-	  Pcalc();
-	  ip = 1;
-      }
-      // R
-      for (j=1;j<=Snum;j++)
-	Rcalc(j);
-
-      // Output Results
-      printf("\n%s It=%d(%5.3fP.C.):%fmV %fuA", fileout, i, (i*df), VOLT[1]*1e3, CURRENT[1]*1e6);
-      //if (plasma == 1)
-	//  for(m=0;m<NS;m++)
-	  //    printf(" %f ",UX[sx/2][sy/2][sz/2][2][m]*1e3);
-      if (((i-1)%frate==0) & (fields==1) )
-      	{
-      	  //printf(" Writing Data");
-	  outputfd(file_fd, i, timev);
+	{
+	  // Calculate Fields	(Finite Difference Part)
+	  if (FUSE == 1)
+	    {
+	      // E, Mur, sources and B in one pass over the grid (temporal.h)
+	      if (plasma == 1)
+		FUSEDstep(timev, Emodrows, PLASMA_COLD ? EMODC_BYTES : EMOD_BYTES);
+	      else
+		FUSEDstep(timev, Erows, E_BYTES);
+	    }
+	  else
+	    {
+	      // E
+	      if (plasma == 1)
+		Ecalcmod();
+	      else
+		Ecalc();
+	      EBCcalc();
+	      for (j=1;j<=Snum;j++)
+		Esource(timev,j);
+	      // B
+	      Bcalc();
+	    }
+	  // Plasma
+	  if (plasma == 1) //& ((ip*df*1e3) >= 1))
+	  {
+	      Pcalc();
+	      ip = 1;
+	  }
+	  // R
+	  for (j=1;j<=Snum;j++)
+	    Rcalc(j);
 	}
-      fprintf(file_vc,"%e", timev);
-      for (j = 1; j <= Snum; j++)
-	fprintf(file_vc,"\t%e\t%e", VOLT[j], CURRENT[j]);
-      fprintf(file_vc,"\n");
+
+      for (s=0;s<n;s++)
+	{
+	  if (n > 1)
+	    for (j=1;j<=Snum;j++)
+	      {
+		VOLT[j] = tvolt[s*(Snum+1)+j];
+		CURRENT[j] = tcurrent[s*(Snum+1)+j];
+	      }
+
+	  // Output Results
+	  printf("\n%s It=%d(%5.3fP.C.):%fmV %fuA", fileout, i, (i*df), VOLT[1]*1e3, CURRENT[1]*1e6);
+	  //if (plasma == 1)
+	    //  for(m=0;m<NS;m++)
+	      //    printf(" %f ",UX[sx/2][sy/2][sz/2][2][m]*1e3);
+	  if (((i-1)%frate==0) & (fields==1) )
+	    {
+	      //printf(" Writing Data");
+	      outputfd(file_fd, i, timev);
+	    }
+	  fprintf(file_vc,"%e", timev);
+	  for (j = 1; j <= Snum; j++)
+	    fprintf(file_vc,"\t%e\t%e", VOLT[j], CURRENT[j]);
+	  fprintf(file_vc,"\n");
  
-      // Convergance
+	  // Convergance
 
-      // assuming all physics are documented in PLASMA_CYCLE
-      if ((i*df) > PLASMA_CYCLE)
-	Q_flag = 1;
+	  // assuming all physics are documented in PLASMA_CYCLE
+	  if ((i*df) > PLASMA_CYCLE)
+	    Q_flag = 1;
 
-      // Max Iteration Reached
-      if ( i >= FAIL_SAFE )
-	Q_flag = 1;
+	  // Max Iteration Reached
+	  if ( i >= FAIL_SAFE )
+	    Q_flag = 1;
 
-      // Check for Stability
-       // Only checks main soucres
-      //if ( ( CURRENT[1][i] > 1e3 ) | ( CURRENT[1][i] < -1e3 ) )
+	  // Check for Stability
+	   // Only checks main soucres
+	  //if ( ( CURRENT[1][i] > 1e3 ) | ( CURRENT[1][i] < -1e3 ) )
 //	{
 //	  printf("\n");
 //	  printf("***************************\n");
@@ -339,15 +501,17 @@ int main(int argc, char*argv[])
 //	  Q_flag = 1;
 //        }
 
-      // Update increments
-      timev += dt;
-      i += 1;
-      ip += 1;
+	  // Update increments
+	  timev += dt;
+	  i += 1;
+	  ip += 1;
+	}
 
       // Use to exit for testing
       //       Q_flag = 1;
 
     }	
+  cstop = clock();
   printf("\n--------------------------------------------------------------------------------\n");
   printf("\n");
 
@@ -359,35 +523,38 @@ int main(int argc, char*argv[])
   
   // clear memory
   printf("Clearing  Memory \n");
-  freedarray4(EX, 1, sx, 1, sy, 1, sz, 0, 1);
-  freedarray4(EY, 1, sx, 1, sy, 1, sz, 0, 1);
-  freedarray4(EZ, 1, sx, 1, sy, 1, sz, 0, 1);
-  EMBCfree();
-  freedarray4(BX, 1, sx, 1, sy, 1, sz, 0, 1);
-  freedarray4(BY, 1, sx, 1, sy, 1, sz, 0, 1);
-  freedarray4(BZ, 1, sx, 1, sy, 1, sz, 0, 1);
-  freedarray3(ERX, 1, sx, 1, sy, 1, sz);
-  freedarray3(ERY, 1, sx, 1, sy, 1, sz);
-  freedarray3(ERZ, 1, sx, 1, sy, 1, sz);
-  if (plasma == 1)
-    PLASMAfree();
+  arenarelease();
+  SPANfree();
   freeiarray2(Sloc, 1, Snum, 0, 5);
   freedarray1(Spar, 1, Snum);
   freedarray1(VOLT, 1, Snum);
   freedarray1(CURRENT, 1, Snum);
+  if (tn > 1)
+    {
+      freedarray1(tv, 0, tn-1);
+      freedarray1(tvolt, 0, tn*(Snum+1)-1);
+      freedarray1(tcurrent, 0, tn*(Snum+1)-1);
+    }
 	
   // display program data
   time(&tstop);
   timev = difftime(tstop,tstart);
   printf("\nProgram Stats.\n");
-  printf("\tUsed %d K bytes \n",(allocate/1024));
+  printf("\tUsed %llu K bytes \n",(allocate/1024));
   trem = (int)timev / 3600;
   printf("\tElapsed Time %d:",trem);
   timev = timev - trem*3600;
   trem = (int)timev / 60;
   printf("%d:",trem);
   timev = timev - trem*60;
-  printf("%5.2f\n\n",timev);
+  printf("%5.2f\n",timev);
+  timev = (double)(cstop - cstart) / CLOCKS_PER_SEC;
+  rate = 0;
+  if (timev > 0)
+    rate = (double)sx*sy*sz*(i-1) / timev;
+  printf("\tTime Loop %5.2f s (%d iterations, %5.3f Mcells/s)\n",timev,i-1,rate*1e-6);
+  TILEreport();
+  printf("\n");
 
   if (Q_flag == 3)
     return 3;
@@ -433,6 +600,63 @@ int main(int argc, char*argv[])
 //////////////////////////////////////////////////////////
 
 
+/*****************************************************************************/
+/////////////////////////////////////////////////////////////
+// Allocates the field, boundary and plasma arrays          /
+//     Run once while the arena plans and once to carve     /
+/////////////////////////////////////////////////////////////
+void Allocate()
+{
+  EX = ebfield3(1, sx, 1, sy, 1, sz, "EX");
+  EY = ebfield3(1, sx, 1, sy, 1, sz, "EY");
+  EZ = ebfield3(1, sx, 1, sy, 1, sz, "EZ");
+  EMBCallocate();
+  BX = ebfield3(1, sx, 1, sy, 1, sz, "BX");
+  BY = ebfield3(1, sx, 1, sy, 1, sz, "BY");
+  BZ = ebfield3(1, sx, 1, sy, 1, sz, "BZ");
+  BXP = ebfield3(1, sx, 1, sy, 1, sz, "BXP");
+  BYP = ebfield3(1, sx, 1, sy, 1, sz, "BYP");
+  BZP = ebfield3(1, sx, 1, sy, 1, sz, "BZP");
+  MATallocate();                        // 1/Relitive Pervitvity, charging and plasma flags (material map)
+  if (plasma == 1)
+    PLASMAallocate();
+}
+
+/*****************************************************************************/
+/////////////////////////////////////////////////////////////
+// Dry run: prints the per array memory plan and compares  /
+//     it against available memory without allocating      /
+//     Returns 0 if the run fits, 2 if not (as exit(2))     /
+/////////////////////////////////////////////////////////////
+int DryRun()
+{
+  unsigned long long need, avail, tables;
+
+  printf("MEMORY PLAN (dry run, nothing allocated)\n");
+  arenaplan();
+  Allocate();
+  arenareport();
+  // Source tables are small and stay on malloc (Sloc, Spar, VOLT, CURRENT)
+  tables = (unsigned long long) Snum*(6*sizeof(int) + sizeof(int *) + 3*sizeof(double));
+  need = arenabytes() + tables;
+  printf("\tSource tables        %15llu\n", tables);
+  printf("\tRequired             %15llu (%llu M bytes)\n", need, need >> 20);
+  avail = availablememory();
+  if (avail == 0)
+    {
+      printf("\tAvailable memory unknown on this system\n");
+      return 0;
+    }
+  printf("\tAvailable            %15llu (%llu M bytes)\n", avail, avail >> 20);
+  if (need > avail)
+    {
+      printf("\tDOES NOT FIT (short by %llu M bytes)\n", (need - avail) >> 20);
+      return 2;
+    }
+  printf("\tFits (%4.1f%% of available)\n", 100.0*need/avail);
+  return 0;
+}
+
 /*****************************************************************************/
 /////////////////////////////////////
 // Reassigns Control-C to exit loop /
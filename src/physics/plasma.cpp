@@ -1,8 +1,13 @@
 #include "plasma.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include "../utils/constants.h"
 #include "../utils/memallocate.h"
+#include "../fields/tiling.h"
+#include "../fields/field_kernels.h"
+#include "../fields/spans.h"
+#include "../fields/temporal.h"
 
 // Variable Definitions
 double FREQ_PLASMA = 5.3e6;			// Plasma Frequency (Hz)
@@ -15,64 +20,135 @@ double UY_0 = 1.0;
 double UZ_0 = 1.0;
 double T = 0.0;					// Temparature in Kelvin
 double Charge = 1;                              // Delta for charging BC on Antenna (effects electrons only)
+int NS = 3;                                     // Number of species (PLASMAspecies)
+int PLASMA_COLD = 0;                            // Cold, drift free plasma kernels (PLASMAcold)
+int PLASMA_DENSITY = 1;                         // N is allocated and advanced
 
-double N_0[NS];                                 // initial density of species 
-double M[NS];                                   // Array of masses for species
-double Q[NS];                                   // Array of charges for species
+double *N_0;                                    // initial density of species 
+double *M;                                      // Array of masses for species
+double *Q;                                      // Array of charges for species
+static double *POP;                             // Population distribution (electrons = 1, the ions are scaled to sum to 1)
 
-double *****UX, *****UY, *****UZ;	        // Partical Movement NOTE: [x][y][z][time][species:0=electron,1+=ions] 1/26/05
-double *****N;					// Density (same as UX)
-double ***SIG;					// Conductivity (used to define plasma field)
-double ***QF;                                   // Charging Factor (for electrons only
+Field (*UX)[3], (*UY)[3], (*UZ)[3];	        // Partical Movement NOTE: [species:0=electron,1+=ions][time](x,y,z), time levels rotated by Pcalc
+Field (*N)[3];					// Density (same as UX)
+
+static double *JROW;                            // Ecalcmod scratch, current density of one (i,j) row (x,y,z) per thread
+static double *ABROW;                           // Ucalc scratch, averaged B of one (i,j) row (x,y,z) per thread
 
 // Externs for Field Arrays (defined in pffdtd.cpp or field modules, declared in plasma.h used here)
 // They are included via plasma.h -> which likely should include field header or declare them? 
 // Current plasma.h has them as externs.
 
-int PLASMAallocate(int allocate)
+// Built in species table (electrons, O+, NO+, O2+), used without a species file
+static const double SP_MASS[] = {ME, 2.6566e-26, 4.9824e-26, 5.3133e-26};
+static const double SP_CHARGE[] = {-1, 1, 1, 1};
+static const double SP_POP[] = {1, 0.75, 0.25, 0.1};
+#define SP_BUILTIN 4
+
+// Sets the n species of the run from mass (kg), charge (in e, electrons -1) and
+// population, or the first n of the built in table when mass is NULL. The first
+// species must be electrons (the plasma frequency sets their density). Populations must
+// be positive: N_0 of a species divides its pressure term and the ion populations are
+// normalized by their sum. Sizes every species array, so must be called before
+// PLASMAallocate. Returns 1 on a bad table.
+int PLASMAspecies(int n, const double *mass, const double *charge, const double *pop)
+{
+  int m;
+
+  if (mass == NULL)
+    {
+      if ((n < 1) || (n > SP_BUILTIN))
+	{
+	  printf("Species must be 1 to %d without a species file\n", SP_BUILTIN);
+	  return 1;
+	}
+      mass = SP_MASS;
+      charge = SP_CHARGE;
+      pop = SP_POP;
+    }
+  if ((n < 1) || (charge[0] >= 0))
+    {
+      printf("The first species must be electrons (negative charge)\n");
+      return 1;
+    }
+  for (m=0;m<n;m++)
+    if ((mass[m] <= 0) || (pop[m] <= 0))
+      {
+	printf("Species %d: mass and population must be positive\n", m);
+	return 1;
+      }
+  NS = n;
+  M = darray1(0, NS-1);
+  Q = darray1(0, NS-1);
+  N_0 = darray1(0, NS-1);
+  POP = darray1(0, NS-1);
+  for (m=0;m<NS;m++)
+    {
+      M[m] = mass[m];
+      Q[m] = charge[m] * -QE;
+      POP[m] = pop[m];
+    }
+  // Handles only, the arrays are allocated by PLASMAallocate (N may not be)
+  UX = (Field (*)[3]) calloc(NS, sizeof(Field[3]));
+  UY = (Field (*)[3]) calloc(NS, sizeof(Field[3]));
+  UZ = (Field (*)[3]) calloc(NS, sizeof(Field[3]));
+  N = (Field (*)[3]) calloc(NS, sizeof(Field[3]));
+  printf("SPECIES: %d (%s)\n", NS, (NS <= NS_MAX) ? "unrolled kernels" : "general kernels");
+  for (m=0;m<NS;m++)
+    printf("\t#%d M = %e kg Q = %+.0f e population %5.3f\n", m, M[m], charge[m], POP[m]);
+  return 0;
+}
+
+// A plasma with T = 0 and no drift has no pressure term in U and no drift current in E,
+// the only places N is read, so N cannot feed back into the fields. Such runs use the
+// kernel forms without those terms (COLD = 1 below), and unless the density is written
+// out (density = 1) N is not allocated or advanced at all. on = 0 keeps the full
+// kernels (--nocold). Must be called before PLASMAallocate.
+void PLASMAcold(int on, int density)
+{
+  PLASMA_COLD = ((on == 1) && (T == 0.0) && (UX_0 == 0.0) && (UY_0 == 0.0) && (UZ_0 == 0.0)) ? 1 : 0;
+  PLASMA_DENSITY = ((PLASMA_COLD == 0) || (density == 1)) ? 1 : 0;
+  if (PLASMA_COLD == 1)
+    printf("COLD PLASMA: T = 0 and no drift, %s\n", PLASMA_DENSITY ? "N only advanced for the output" : "N is not allocated or advanced");
+}
+
+void PLASMAallocate()
 {
-  int size;
+  int l, m;
   
-  size =  sx*sy*sz*6*sizeof(double) + sy*sz*6*sizeof(double) + sz*6*sizeof(double) + 6*sizeof(double) + sizeof(double);
-  UX = darray5(1, sx, 1, sy, 1, sz, 0, 2, 0, NS-1);
-  UY = darray5(1, sx, 1, sy, 1, sz, 0, 2, 0, NS-1);
-  UZ = darray5(1, sx, 1, sy, 1, sz, 0, 2, 0, NS-1);
-  N = darray5(1, sx, 1, sy, 1, sz, 0, 2, 0, NS-1);
-  allocate = allocate + 8*size;
-  SIG = darray3(1, sx, 1, sy, 1, sz);
-  allocate = allocate + 1*size;
-  QF = darray3(1, sx, 1, sy, 1, sz);
-  allocate = allocate + size;
-
-  // array in routines (AB)
-  allocate = allocate+3*(sx-2)*(sy-2)*(sz-2)*sizeof(double);
-
-  return allocate;
+  // Species major: every species and component is its own 3D array with the same
+  // shape as the grid arrays, so one offset indexes all of them and k is unit stride
+  for (m=0;m<NS;m++)
+    for (l=0;l<=2;l++)
+      {
+	UX[m][l] = field3(1, sx, 1, sy, 1, sz, "UX");
+	UY[m][l] = field3(1, sx, 1, sy, 1, sz, "UY");
+	UZ[m][l] = field3(1, sx, 1, sy, 1, sz, "UZ");
+	if (PLASMA_DENSITY == 1)
+	  N[m][l] = field3(1, sx, 1, sy, 1, sz, "N");
+      }
+  // SIG and QF are flags in the material map (MAT_SIG, MAT_QF)
+
+  // current row in Ecalcmod (J)
+  JROW = (double *)aalloc(SLAB_THREADS*3*(sz+1)*sizeof(double), "JROW");
+  // array in routines (AB), the averaged B of a row in Ucalc (only read with drift)
+  ABROW = (double *)aalloc(SLAB_THREADS*3*(sz+1)*sizeof(double), "AB");
 }
 
 void PLASMAclear()
 {
   int i, j, k, l, m;
-  double pop[NS];                       // Population distribution
+  double ions;                          // Population of the ions in use
 
-  // Ion mass (H=1.6727e-27, N=2.3257e-26, O=2.6566e-26, N2=4.6515e-26, NO=4.9824e-26, O2=5.3133e-26)
-  // either enter actual weight or use AMU and atomic number to have program i.e. [ME 12*AMU-ME ...]
- 
-  M[0] = ME;                            // Masses (first must be electrons)
-  Q[0] = QE;                            // Charges (first must be electrons)
-  pop[0] = 1;                           // Population distribution (electrons = 1, sum of ions should equal electrons)
-  M[1] = 2.6566e-26;
-  Q[1] = -QE;
-  pop[1] = 0.75;
-  M[2] = 4.9824e-26;
-  Q[2] = -QE;
-  pop[2] = 0.25;
-
-  N_0[0] = 4*PI*PI*FREQ_PLASMA*FREQ_PLASMA*ME*EPSILON_0/QE/QE;
-  if (NS > 0)
-      for (m=1;m<NS;m++)
-	  N_0[m] = N_0[0]*pop[m];
+  // The ions in use are scaled to the electron density
+  ions = 0;
+  for (m=1;m<NS;m++)
+    ions += POP[m];
+  N_0[0] = 4*PI*PI*FREQ_PLASMA*FREQ_PLASMA*M[0]*EPSILON_0/Q[0]/Q[0];
+  for (m=1;m<NS;m++)
+    N_0[m] = N_0[0]*POP[m]/ions;
  
+  SLAB_FOR(j, k, l, m)
   for (i=1;i<=sx;i++)
     for (j=1;j<=sy;j++)
       for (k=1;k<=sz;k++)
@@ -81,183 +157,528 @@ void PLASMAclear()
 	    {
 		for (m=0;m<NS;m++)
 		{
-		    UX[i][j][k][l][m] = 0.0;
-		    UY[i][j][k][l][m] = 0.0;
-		    UZ[i][j][k][l][m] = 0.0;
-		    N[i][j][k][l][m] = 0.0;
+		    UX[m][l](i,j,k) = 0.0;
+		    UY[m][l](i,j,k) = 0.0;
+		    UZ[m][l](i,j,k) = 0.0;
+		    if (PLASMA_DENSITY == 1)
+		      N[m][l](i,j,k) = 0.0;
 		}
-	      SIG[i][j][k] = 0;
 	    }
-	    QF[i][j][k] = 1;
+	    MAT(i,j,k) &= ~(MAT_SIG | MAT_QF);
 	  }
 	
   // Turns Plasma On
   for (i=6;i<sx-4;i++)
     for (j=6;j<sy-4;j++)
       for (k=6;k<sz-4;k++)
-	if ((ERX[i][j][k]==1) || (ERY[i][j][k]==1) || (ERZ[i][j][k]==1))
-	  SIG[i][j][k] = 1.0;
+	if ((MATERX[MAT(i,j,k)]==1) || (MATERY[MAT(i,j,k)]==1) || (MATERZ[MAT(i,j,k)]==1))
+	  MAT(i,j,k) |= MAT_SIG;
 
  
 }
 
-void PLASMAfree()
+// Everything the U and N rows need besides the species arrays. U reads the newest N
+// (N[nl]), N the U level before the one being written (see Pcalc)
+struct PlasmaArgs
 {
-  freedarray5(UX, 1, sx, 1, sy, 1, sz, 0, 2, 0, 2);
-  freedarray5(UY, 1, sx, 1, sy, 1, sz, 0, 2, 0, 2);
-  freedarray5(UZ, 1, sx, 1, sy, 1, sz, 0, 2, 0, 2);
-  freedarray5(N, 1, sx, 1, sy, 1, sz, 0, 2, 0, 2);
-  freedarray3(SIG, 1, sx, 1, sy, 1, sz);
-  freedarray3(QF, 1, sx, 1, sy, 1, sz);
+  const ebreal *bx0, *by0, *bz0, *bx1, *by1, *bz1; // B at both levels (BXP.., BX..)
+  const ebreal *ex, *ey, *ez;
+  int nl;
+  long si, sj;
+  double C_U_1, C_U_2, C_U_TX, C_U_TY, C_U_TZ;
+  double BX_0, BY_0, BZ_0, EeX, EeY, EeZ;
+  double C_N_tx, C_N_ty, C_N_tz;
+};
 
+// Row arguments of Ucalc and Ncalc, with the newest N in level nl (N[nl])
+static void Pargs(PlasmaArgs &a, int nl)
+{
+  a.bx0 = BXP.base; a.by0 = BYP.base; a.bz0 = BZP.base;
+  a.bx1 = BX.base; a.by1 = BY.base; a.bz1 = BZ.base;
+  a.ex = EX.base; a.ey = EY.base; a.ez = EZ.base;
+  a.nl = nl;
+  // Plasma and grid arrays share one shape, so c indexes all of them
+  a.si = BX.s[0]; a.sj = BX.s[1];
+  a.C_U_1 = 2*dt;
+  a.C_U_2 = 4*PI*dt;
+  a.C_U_TX = K*T*dt/dx;
+  a.C_U_TY = K*T*dt/dy;
+  a.C_U_TZ = K*T*dt/dz;
+  a.BX_0 = FREQ_CYC*2*PI*ME/QE*sin(ANGLE_E_CYC*PI/180)*cos(ANGLE_A_CYC*PI/180);
+  a.BY_0 = FREQ_CYC*2*PI*ME/QE*sin(ANGLE_E_CYC*PI/180)*sin(ANGLE_A_CYC*PI/180);
+  a.BZ_0 = FREQ_CYC*2*PI*ME/QE*cos(ANGLE_E_CYC*PI/180);
+  a.EeX = UY_0 * a.BZ_0 - UZ_0 * a.BZ_0; //Effective E field (DC -> UxB)
+  a.EeY = UZ_0 * a.BX_0 - UX_0 * a.BZ_0;
+  a.EeZ = UX_0 * a.BY_0 - UY_0 * a.BX_0;
+  a.C_N_tx = dt/dx;
+  a.C_N_ty = dt/dy;
+  a.C_N_tz = dt/dz;
 }
 
+// Ucalc of every species on row (i,j), k = 4..sz-4. U = 1 (cubic cells, see
+// field_kernels.h) takes one pressure coefficient C_U_T/N_0 for all three axes and
+// multiplies by 1/M instead of dividing, which agrees with U = 0 to rounding. COLD = 1 is
+// the cold, drift free form (PLASMAcold): no pressure term and, as the averaged B only
+// enters times the drift, no B at all. S is the number of species (NS), or 0 for any
+// number (the general form, for more than NS_MAX).
+template <int U, int COLD, int S>
+static void Urow(const PlasmaArgs &a, int i, int j)
+{
+  int k, ke, m;
+  long c, p;
+  double qf, fx, fy, fz;
+  const double C_U_1 = a.C_U_1, C_U_2 = a.C_U_2;
+  const double C_U_TX = a.C_U_TX, C_U_TY = a.C_U_TY, C_U_TZ = a.C_U_TZ;
+  const double BX_0 = a.BX_0, BY_0 = a.BY_0, BZ_0 = a.BZ_0;
+  const double EeX = a.EeX, EeY = a.EeY, EeZ = a.EeZ;
+  const ebreal *RESTRICT bx0 = a.bx0, *RESTRICT bx1 = a.bx1;
+  const ebreal *RESTRICT by0 = a.by0, *RESTRICT by1 = a.by1;
+  const ebreal *RESTRICT bz0 = a.bz0, *RESTRICT bz1 = a.bz1;
+  const ebreal *RESTRICT ex = a.ex, *RESTRICT ey = a.ey, *RESTRICT ez = a.ez;
+  const long si = a.si, sj = a.sj, sk = 1;
+  const long r = (long)(i-2)*(sy-2)+(j-2);
+  double *RESTRICT abx = ABROW + SLAB_THREAD*3*(sz+1), *RESTRICT aby = abx + (sz+1), *RESTRICT abz = abx + 2*(sz+1);
+
+  // The B averages of the row are taken once (ABROW) and shared by the species, each
+  // species is then a unit stride sweep of the row run by run
+  // Calculate averages(using linear techniques set B1=0), summed in double
+  c = BX.index(i,j,4);
+  if (!COLD)
+    for (k=4;k<sz-3;k++,c++)
+      {
+	abx[k] = ((double)bx0[c] + bx0[c+sj] + bx0[c+sj+sk] + bx0[c+sk]
+		  + bx1[c] + bx1[c+sj] + bx1[c+sj+sk] + bx1[c+sk])/8;
+	aby[k] = ((double)by0[c] + by0[c+si] + by0[c+si+sk] + by0[c+sk]
+		  + by1[c] + by1[c+si] + by1[c+si+sk] + by1[c+sk])/8;
+	abz[k] = ((double)bz0[c] + bz0[c+si] + bz0[c+si+sj] + bz0[c+sj]
+		  + bz1[c] + bz1[c+si] + bz1[c+si+sj] + bz1[c+sj])/8;
+      }
+
+  for (m=0;m<(S ? S : NS);m++)
+    {
+      // Only [2] is written, the history was rotated by Pcalc
+      const double *RESTRICT ux0 = UX[m][0].base, *RESTRICT ux1 = UX[m][1].base;
+      const double *RESTRICT uy0 = UY[m][0].base, *RESTRICT uy1 = UY[m][1].base;
+      const double *RESTRICT uz0 = UZ[m][0].base, *RESTRICT uz1 = UZ[m][1].base;
+      double *RESTRICT ux2 = UX[m][2].base, *RESTRICT uy2 = UY[m][2].base, *RESTRICT uz2 = UZ[m][2].base;
+      const double *RESTRICT n2 = N[m][a.nl].base;
+      const double Qm = Q[m], Mm = M[m], N_0m = N_0[m];
+      const double CT = C_U_TX / N_0m, IM = 1 / Mm;
+
+      for (p=SROW[r];p<SROW[r+1];p++)
+	{
+	  // One material run of the row, clipped to 4..sz-4, takes QF once (spans.h)
+	  k = (SPANS[p].k0 > 4) ? SPANS[p].k0 : 4;
+	  ke = (SPANS[p].k1 < sz-3) ? SPANS[p].k1 : sz-3;
+	  qf = MATQF[SPANS[p].id];
+	  c = BX.index(i,j,k);
+	  for (;k<ke;k++,c++)
+	    {
+	      // Assuming plasma remains consant at boundary (i.e. delta n = 0) so warm plasma equaitions can be used throughout
+	      // Note:NE is the newest density since it has not been calculated yet this step
+	      if (COLD)
+		{
+		  fx = qf * (Qm*dt * ( (double)ex[c] + ex[c+si] ) + Qm*C_U_1 * ( uy1[c] * BZ_0 - uz1[c] * BY_0 ) );
+		  fy = qf * (Qm*dt * ( (double)ey[c] + ey[c+sj] ) + Qm*C_U_1 * ( uz1[c] * BX_0 - ux1[c] * BZ_0 ) );
+		  fz = qf * (Qm*dt * ( (double)ez[c] + ez[c+sk] ) + Qm*C_U_1 * ( ux1[c] * BY_0 - uy1[c] * BX_0 ) );
+		  ux2[c] = ux0[c] + (U ? fx * IM : fx / Mm) - C_U_2 * FREQ_COL * FREQ_PLASMA * ux1[c];
+		  uy2[c] = uy0[c] + (U ? fy * IM : fy / Mm) - C_U_2 * FREQ_COL * FREQ_PLASMA * uy1[c];
+		  uz2[c] = uz0[c] + (U ? fz * IM : fz / Mm) - C_U_2 * FREQ_COL * FREQ_PLASMA * uz1[c];
+		  continue;
+		}
+	      if (U)
+		{
+		  ux2[c] = ux0[c] + (qf * (Qm*dt * ( (double)ex[c] + ex[c+si] )
+					      + Qm*C_U_1 * ( uy1[c] * BZ_0 + UY_0 * abz[k]
+							   - uz1[c] * BY_0 - UZ_0 * aby[k]
+							   + EeX) )
+				     - CT * ( n2[c+si] - n2[c-si] ) ) * IM
+		    - C_U_2 * FREQ_COL * FREQ_PLASMA * ( ux1[c] - UX_0 );
+		  uy2[c] = uy0[c] + (qf * (Qm*dt * ( (double)ey[c] + ey[c+sj] )
+					      + Qm*C_U_1 * ( uz1[c] * BX_0 + UZ_0 * abx[k]
+							   - ux1[c] * BZ_0 - UX_0 * abz[k]
+							   + EeY) )
+				     - CT * ( n2[c+sj] - n2[c-sj] ) ) * IM
+		    - C_U_2 * FREQ_COL * FREQ_PLASMA * ( uy1[c] - UY_0 );
+		  uz2[c] = uz0[c] + (qf * (Qm*dt * ( (double)ez[c] + ez[c+sk] )
+					      + Qm*C_U_1 * ( ux1[c] * BY_0 + UX_0 * aby[k]
+							   - uy1[c] * BX_0 - UY_0 * abx[k]
+							   + EeZ ) )
+				     - CT * ( n2[c+sk] - n2[c-sk] ) ) * IM
+		    - C_U_2 * FREQ_COL * FREQ_PLASMA * ( uz1[c] - UZ_0 );
+		  continue;
+		}
+	      // Calculate UX
+	      ux2[c] = ux0[c] + (qf * (Qm*dt * ( (double)ex[c] + ex[c+si] )
+					  + Qm*C_U_1 * ( uy1[c] * BZ_0 + UY_0 * abz[k]
+						       - uz1[c] * BY_0 - UZ_0 * aby[k]
+						       + EeX) )
+				 - C_U_TX * ( n2[c+si] - n2[c-si] ) / N_0m ) / Mm
+		- C_U_2 * FREQ_COL * FREQ_PLASMA * ( ux1[c] - UX_0 );
+	      // Calculate UY
+	      uy2[c] = uy0[c] + (qf * (Qm*dt * ( (double)ey[c] + ey[c+sj] )
+					  + Qm*C_U_1 * ( uz1[c] * BX_0 + UZ_0 * abx[k]
+						       - ux1[c] * BZ_0 - UX_0 * abz[k]
+						       + EeY) )
+				 - C_U_TY * ( n2[c+sj] - n2[c-sj] ) / N_0m ) / Mm
+		- C_U_2 * FREQ_COL * FREQ_PLASMA * ( uy1[c] - UY_0 );
+	      // Calculate UZ
+	      uz2[c] = uz0[c] + (qf * (Qm*dt * ( (double)ez[c] + ez[c+sk] )
+					  + Qm*C_U_1 * ( ux1[c] * BY_0 + UX_0 * aby[k]
+						       - uy1[c] * BX_0 - UY_0 * abx[k]
+						       + EeZ ) )
+				 - C_U_TZ * ( n2[c+sk] - n2[c-sk] ) / N_0m ) / Mm
+		- C_U_2 * FREQ_COL * FREQ_PLASMA * ( uz1[c] - UZ_0 );
+	    }
+	}
+    }
+}
+
+// Ncalc of every species on row (i,j), k = 5..sz-5. U = 1 (cubic cells) multiplies N_0
+// and the drift by the one C_N_t once instead of every difference. COLD = 1 has no drift
+// terms and does not read N[1].
+template <int U, int COLD, int S>
+static void Nrow(const PlasmaArgs &a, int i, int j)
+{
+  int k, m;
+  long c;
+  const double C_N_tx = a.C_N_tx, C_N_ty = a.C_N_ty, C_N_tz = a.C_N_tz;
+  const long si = a.si, sj = a.sj, sk = 1;
+
+  for (m=0;m<(S ? S : NS);m++)
+    {
+      const double *RESTRICT n0 = N[m][0].base, *RESTRICT n1 = N[m][1].base;
+      double *RESTRICT n2 = N[m][2].base;
+      const double *RESTRICT ux = UX[m][1].base, *RESTRICT uy = UY[m][1].base, *RESTRICT uz = UZ[m][1].base;
+      const double N_0m = N_0[m];
+      const double NC = N_0m * C_N_tx, UXC = UX_0 * C_N_tx, UYC = UY_0 * C_N_tx, UZC = UZ_0 * C_N_tx;
+
+      c = EX.index(i,j,5);
+      for(k=5;k<sz-4;k++,c++)
+	{
+	  if (COLD && U)
+	    {
+	      n2[c] = n0[c] - NC * ( ( ux[c+si] - ux[c-si] )
+				   + ( uy[c+sj] - uy[c-sj] )
+				   + ( uz[c+sk] - uz[c-sk] ) );
+	      continue;
+	    }
+	  if (COLD)
+	    {
+	      n2[c] = n0[c] - N_0m * ( ( ux[c+si] - ux[c-si] ) * C_N_tx
+				     + ( uy[c+sj] - uy[c-sj] ) * C_N_ty
+				     + ( uz[c+sk] - uz[c-sk] ) * C_N_tz );
+	      continue;
+	    }
+	  if (U)
+	    {
+	      n2[c] = n0[c] - ( NC * ( ( ux[c+si] - ux[c-si] )
+				     + ( uy[c+sj] - uy[c-sj] )
+				     + ( uz[c+sk] - uz[c-sk] ) )
+				+ UXC * ( n0[c+si] - n1[c-si] )
+				+ UYC * ( n0[c+sj] - n1[c-sj] )
+				+ UZC * ( n0[c+sk] - n1[c-sk] ) );
+	      continue;
+	    }
+	  // Calculate Body (Expanded 1st order terms)
+	  // Note: the Time difference in the density (last half of the equation) is due to the fact that the cells
+	  // "ahead" of the current calculation have not been updated in time. The history used to be shifted
+	  // cell by cell inside this loop, so cells ahead (+1) still held the previous level, now in [0]
+	  n2[c] = n0[c] - ( N_0m * ( ( ux[c+si] - ux[c-si] ) * C_N_tx
+				   + ( uy[c+sj] - uy[c-sj] ) * C_N_ty
+				   + ( uz[c+sk] - uz[c-sk] ) * C_N_tz )
+			    + UX_0 * ( n0[c+si] - n1[c-si] ) * C_N_tx
+			    + UY_0 * ( n0[c+sj] - n1[c-sj] ) * C_N_ty
+			    + UZ_0 * ( n0[c+sk] - n1[c-sk] ) * C_N_tz );
+	}
+    }
+}
+
+typedef void (*PlasmaRow)(const PlasmaArgs &a, int i, int j);
+
+// Every kernel form f<U, COLD, S>, indexed [FIELD_UNIFORM][PLASMA_COLD][Pspecies()], so
+// the species loops are unrolled for the species count of the run
+#define PLASMA_FORMS(f) \
+  {{{f<0,0,0>, f<0,0,1>, f<0,0,2>, f<0,0,3>, f<0,0,4>}, {f<0,1,0>, f<0,1,1>, f<0,1,2>, f<0,1,3>, f<0,1,4>}}, \
+   {{f<1,0,0>, f<1,0,1>, f<1,0,2>, f<1,0,3>, f<1,0,4>}, {f<1,1,0>, f<1,1,1>, f<1,1,2>, f<1,1,3>, f<1,1,4>}}}
+
+static const PlasmaRow UROWS[2][2][NS_MAX+1] = PLASMA_FORMS(Urow);
+static const PlasmaRow NROWS[2][2][NS_MAX+1] = PLASMA_FORMS(Nrow);
+
+// S of the kernel forms for NS species (0 = the general form)
+static inline int Pspecies()
+{
+  return (NS <= NS_MAX) ? NS : 0;
+}
+
+// Ucalc, with U rotated and N not yet (the newest N is N[2])
 void Ucalc()
 {
-  int i, j, k, m;
-  double C_U_1 = 2*dt;
-  double C_U_2 = 4*PI*dt;
-  double C_U_TX = K*T*dt/dx;
-  double C_U_TY = K*T*dt/dy;
-  double C_U_TZ = K*T*dt/dz;
-  double BX_0 = FREQ_CYC*2*PI*ME/QE*sin(ANGLE_E_CYC*PI/180)*cos(ANGLE_A_CYC*PI/180);
-  double BY_0 = FREQ_CYC*2*PI*ME/QE*sin(ANGLE_E_CYC*PI/180)*sin(ANGLE_A_CYC*PI/180);
-  double BZ_0 = FREQ_CYC*2*PI*ME/QE*cos(ANGLE_E_CYC*PI/180);
-  double ABX, ABY, ABZ;
-  double EeX = UY_0 * BZ_0 - UZ_0 * BZ_0; //Effective E field (DC -> UxB)
-  double EeY = UZ_0 * BX_0 - UX_0 * BZ_0;
-  double EeZ = UX_0 * BY_0 - UY_0 * BX_0;
+  int i, j;
+  PlasmaArgs a;
+  PlasmaRow row = UROWS[FIELD_UNIFORM][PLASMA_COLD][Pspecies()];
 
+  Pargs(a, 2);
+  // Rows are independent
+  SLAB_FOR(j)
   for (i=4;i<sx-3;i++)
     for (j=4;j<sy-3;j++)
-      for (k=4;k<sz-3;k++)
-	for (m=0;m<NS;m++)
-	{
-	  // Save Old Values
-	  UX[i][j][k][0][m] = UX[i][j][k][1][m];
-	  UX[i][j][k][1][m] = UX[i][j][k][2][m];
-	  UY[i][j][k][0][m] = UY[i][j][k][1][m];
-	  UY[i][j][k][1][m] = UY[i][j][k][2][m];
-	  UZ[i][j][k][0][m] = UZ[i][j][k][1][m];
-	  UZ[i][j][k][1][m] = UZ[i][j][k][2][m];
-	  
-	  // Calculate averages(using linear techniques set B1=0)
-	  ABX = (BX[i][j][k][0] + BX[i][j+1][k][0] + BX[i][j+1][k+1][0] + BX[i][j][k+1][0]
-	        + BX[i][j][k][1] + BX[i][j+1][k][1] + BX[i][j+1][k+1][1] + BX[i][j][k+1][1])/8;
-	  ABY = (BY[i][j][k][0] + BY[i+1][j][k][0] + BY[i+1][j][k+1][0] + BY[i][j][k+1][0]
-	        + BY[i][j][k][1] + BY[i+1][j][k][1] + BY[i+1][j][k+1][1] + BY[i][j][k+1][1])/8;
-	  ABZ = (BZ[i][j][k][0] + BZ[i+1][j][k][0] + BZ[i+1][j+1][k][0] + BZ[i][j+1][k][0]
-	        + BZ[i][j][k][1] + BZ[i+1][j][k][1] + BZ[i+1][j+1][k][1] + BZ[i][j+1][k][1])/8;
-
-	  // Assuming plasma remains consant at boundary (i.e. delta n = 0) so warm plasma equaitions can be used throughout
-	  // Note:NE is at time [2] since density has not been calculated yet
-	  // Calculate UX
-	  UX[i][j][k][2][m] = UX[i][j][k][0][m] + (QF[i][j][k] * (Q[m]*dt * ( EX[i][j][k][1] + EX[i+1][j][k][1] )
-							         + Q[m]*C_U_1 * ( UY[i][j][k][1][m] * BZ_0 + UY_0 * ABZ
-										- UZ[i][j][k][1][m] * BY_0 - UZ_0 * ABY
-										+ EeX) )
-						  - C_U_TX * ( N[i+1][j][k][2][m] - N[i-1][j][k][2][m] ) / N_0[m] ) / M[m]
-	                    - C_U_2 * FREQ_COL * FREQ_PLASMA * ( UX[i][j][k][1][m] - UX_0 );
-	  // Calculate UY
-	  UY[i][j][k][2][m] = UY[i][j][k][0][m] + (QF[i][j][k] * (Q[m]*dt * ( EY[i][j][k][1] + EY[i][j+1][k][1] )
-								 + Q[m]*C_U_1 * ( UZ[i][j][k][1][m] * BX_0 + UZ_0 * ABX
-										- UX[i][j][k][1][m] * BZ_0 - UX_0 * ABZ
-								                + EeY) )
-						  - C_U_TY * ( N[i][j+1][k][2][m] - N[i][j-1][k][2][m] ) / N_0[m] ) / M[m]
-	                    - C_U_2 * FREQ_COL * FREQ_PLASMA * ( UY[i][j][k][1][m] - UY_0 );
-	  // Calculate UZ
-	  UZ[i][j][k][2][m] = UZ[i][j][k][0][m] + (QF[i][j][k] * (Q[m]*dt * ( EZ[i][j][k][1] + EZ[i][j][k+1][1] )
-								 + Q[m]*C_U_1 * ( UX[i][j][k][1][m] * BY_0 + UX_0 * ABY
-										- UY[i][j][k][1][m] * BX_0 - UY_0 * ABX
-										+ EeZ ) )
-						  - C_U_TZ * ( N[i][j][k+1][2][m] - N[i][j][k-1][2][m] ) / N_0[m] ) / M[m]
-	                    - C_U_2 * FREQ_COL * FREQ_PLASMA * ( UZ[i][j][k][1][m] - UZ_0 );
-	}
+      row(a, i, j);
 }
 
+// Ncalc, with U and N rotated
 void Ncalc()
 {
-  int i, j, k, m;
-  double C_N_tx = dt/dx;
-  double C_N_ty = dt/dy;
-  double C_N_tz = dt/dz;
-	
+  int i, j;
+  PlasmaArgs a;
+  PlasmaRow row = NROWS[FIELD_UNIFORM][PLASMA_COLD][Pspecies()];
+
+  Pargs(a, 1);
+  SLAB_FOR(j)
   for (i=5;i<sx-4;i++)
     for (j=5;j<sy-4;j++)
-      for(k=5;k<sz-4;k++)
-	  for(m=0;m<NS;m++)
-	  {
-	      // Save Old Values
-	      N[i][j][k][0][m] = N[i][j][k][1][m];
-	      N[i][j][k][1][m] = N[i][j][k][2][m];
-
-	      // Calculate Body (Expanded 1st order terms)
-	      // Note: the Time difference in the density (last half of the equation) is due to the fact that the cells
-	      // "ahead" of the current calculation have not been updated in time
-	      N[i][j][k][2][m] = N[i][j][k][0][m] - ( N_0[m] * ( ( UX[i+1][j][k][1][m] - UX[i-1][j][k][1][m] ) * C_N_tx
-								 + ( UY[i][j+1][k][1][m] - UY[i][j-1][k][1][m] ) * C_N_ty
-								 + ( UZ[i][j][k+1][1][m] - UZ[i][j][k-1][1][m] ) * C_N_tz )
-						      + UX_0 * ( N[i+1][j][k][1][m] - N[i-1][j][k][1][m] ) * C_N_tx
-						      + UY_0 * ( N[i][j+1][k][1][m] - N[i][j-1][k][1][m] ) * C_N_ty
-						      + UZ_0 * ( N[i][j][k+1][1][m] - N[i][j][k-1][1][m] ) * C_N_tz );
-	      
+      row(a, i, j);
+}
+
+// Ucalc and Ncalc in one pass, with U and N both rotated (the newest N is then N[1]).
+// N reads U[1], the level before the one Ucalc writes, and Ucalc reads only the newest
+// N, not the N[2] Ncalc writes. The two updates of a step do not depend on each other,
+// so N of a row is computed right after its U, while U[1] and N[1] of the row (read by
+// both) are still in cache, without any lag between the two.
+template <int U, int COLD, int S>
+static void UNsweep()
+{
+  int i, j;
+  PlasmaArgs a;
+
+  Pargs(a, 1);
+  SLAB_FOR(j)
+  for (i=4;i<sx-3;i++)
+    for (j=4;j<sy-3;j++)
+      {
+	Urow<U, COLD, S>(a, i, j);
+	if ((i >= 5) && (i < sx-4) && (j >= 5) && (j < sy-4))
+	  Nrow<U, COLD, S>(a, i, j);
+      }
+}
+
+void UNcalc()
+{
+  static void (*const sweeps[2][2][NS_MAX+1])() = PLASMA_FORMS(UNsweep);
+
+  sweeps[FIELD_UNIFORM][PLASMA_COLD][Pspecies()]();
+}
+
+// Everything an Ecalcmod row needs
+struct EmodArgs
+{
+  ebreal *ex, *ey, *ez;
+  const ebreal *bx, *by, *bz;
+  long si, sj;
+  double C_dx, C_dy, C_dz, C_MU;
+  ERowArgs e;                                   // The same cells for the plain E kernel (no plasma)
+};
+
+// Updates E on the n cells c0.. of one k row segment of material id, with the plasma
+// current (all coefficients are taken once, see spans.h). U = 1 is the cubic cell form
+// of field_kernels.h, the curl differences share one C_d. COLD = 1 (cold, drift free) has
+// no drift current and does not read N.
+template <int U, int COLD, int S>
+static void Emodrow(const EmodArgs &a, long c0, long n, int id)
+{
+  int m;
+  long c, k;
+  ebreal *RESTRICT ex = a.ex, *RESTRICT ey = a.ey, *RESTRICT ez = a.ez;
+  const ebreal *RESTRICT bx = a.bx, *RESTRICT by = a.by, *RESTRICT bz = a.bz;
+  const double cax = MATCAX[id], cay = MATCAY[id], caz = MATCAZ[id];
+  const double cbx = MATCBX[id], cby = MATCBY[id], cbz = MATCBZ[id];
+  const double cj = a.C_MU * MATSIG[id];
+  double *RESTRICT jx = JROW + SLAB_THREAD*3*(sz+1), *RESTRICT jy = jx + (sz+1), *RESTRICT jz = jx + 2*(sz+1);
+  const long si = a.si, sj = a.sj, sk = 1;
+
+  // Calculate current from plasma, one row at a time so each species sum runs along k
+  // (species are added in the same order as before, 0..NS-1)
+  for (k=0;k<n;k++)
+    {
+      jx[k] = 0.0;
+      jy[k] = 0.0;
+      jz[k] = 0.0;
+    }
+  for (m=0;m<(S ? S : NS);m++)
+    {
+      // Newest level of every species
+      const double *RESTRICT ux = UX[m][2].base, *RESTRICT uy = UY[m][2].base, *RESTRICT uz = UZ[m][2].base;
+      const double *RESTRICT nm = N[m][2].base;
+      const double Qm = Q[m], N_0m = N_0[m];
+
+      for (k=0,c=c0;k<n;k++,c++)
+	{
+	  if (COLD)
+	    {
+	      jx[k] = jx[k] + Qm * ( N_0m * (ux[c] + ux[c-si]) );
+	      jy[k] = jy[k] + Qm * ( N_0m * (uy[c] + uy[c-sj]) );
+	      jz[k] = jz[k] + Qm * ( N_0m * (uz[c] + uz[c-sk]) );
+	      continue;
+	    }
+	  jx[k] = jx[k] + Qm * ( N_0m * (ux[c] + ux[c-si]) +  UX_0 * ( nm[c] + nm[c-si]) + 2 * N_0m * UX_0 );
+	  jy[k] = jy[k] + Qm * ( N_0m * (uy[c] + uy[c-sj]) +  UY_0 * ( nm[c] + nm[c-sj]) + 2 * N_0m * UY_0 );
+	  jz[k] = jz[k] + Qm * ( N_0m * (uz[c] + uz[c-sk]) +  UZ_0 * ( nm[c] + nm[c-sk]) + 2 * N_0m * UZ_0 );
 	}
+    }
+
+  // Calculate the body
+  for (k=0,c=c0;k<n;k++,c++)
+    {
+      if (U)
+	{
+	  ex[c] = cax * ex[c] + ( ( ( (double)bz[c+sj] - bz[c] ) - ( (double)by[c+sk] - by[c] ) ) * a.C_dx
+				- cj * jx[k] ) * cbx;
+	  ey[c] = cay * ey[c] + ( ( ( (double)bx[c+sk] - bx[c] ) - ( (double)bz[c+si] - bz[c] ) ) * a.C_dx
+				- cj * jy[k] ) * cby;
+	  ez[c] = caz * ez[c] + ( ( ( (double)by[c+si] - by[c] ) - ( (double)bx[c+sj] - bx[c] ) ) * a.C_dx
+				- cj * jz[k] ) * cbz;
+	  continue;
+	}
+
+      // Calculate Ex
+      ex[c] = cax * ex[c] + ( ( (double)bz[c+sj] - bz[c] ) * a.C_dy
+			    - ( (double)by[c+sk] - by[c] ) * a.C_dz
+			    - cj * jx[k] ) * cbx;
+
+      // Calculate Ey
+      ey[c] = cay * ey[c] + ( ( (double)bx[c+sk] - bx[c] ) * a.C_dz
+			    - ( (double)bz[c+si] - bz[c] ) * a.C_dx
+			    - cj * jy[k] ) * cby;
+
+      // Calculate Ez
+      ez[c] = caz * ez[c] + ( ( (double)by[c+si] - by[c] ) * a.C_dx
+			    - ( (double)bx[c+sj] - bx[c] ) * a.C_dy
+			    - cj * jz[k] ) * cbz;
+    }
+}
+
+// One material run of a row segment: plasma runs with the current, the others with the
+// plain E kernel (there SIG is 0 and the J term drops out exactly)
+template <int U, int COLD, int S>
+static void Emodrun(const EmodArgs &a, long c, long n, int id)
+{
+  if (id & MAT_SIG)
+    Emodrow<U, COLD, S>(a, c, n, id);
+  else
+    Erowm(a.e, c, n, id);
+}
+
+// Ecalcmod of one k row segment, run by run, then the PEC cells back to 0 (spans.h)
+template <int U, int COLD, int S>
+static void Emodspan(const EmodArgs &a, long c, long n)
+{
+  SPANwalk(a, c, n, a.si, a.sj, Emodrun<U, COLD, S>, a.ex, a.ey, a.ez);
+}
+
+typedef void (*EmodRow)(const EmodArgs &a, long c, long n);
+
+// Ecalcmod row of the current cell shape, plasma and species count (FIELDuniform,
+// PLASMAcold, NS)
+static EmodRow Emodselect()
+{
+  static const EmodRow rows[2][2][NS_MAX+1] = PLASMA_FORMS(Emodspan);
+
+  return rows[FIELD_UNIFORM][PLASMA_COLD][Pspecies()];
+}
+
+// Row arguments of Ecalcmod
+static void Emodargs(EmodArgs &a)
+{
+  a.ex = EX.base; a.ey = EY.base; a.ez = EZ.base;
+  a.bx = BX.base; a.by = BY.base; a.bz = BZ.base;
+  a.si = EX.s[0]; a.sj = EX.s[1];
+  a.C_dx = dt/(MU_0*EPSILON_0*dx);
+  a.C_dy = dt/(MU_0*EPSILON_0*dy);
+  a.C_dz = dt/(MU_0*EPSILON_0*dz);
+  a.C_MU = dt/(2*EPSILON_0);
+  a.e.ex = EX.base; a.e.ey = EY.base; a.e.ez = EZ.base;
+  a.e.bx = BX.base; a.e.by = BY.base; a.e.bz = BZ.base;
+  a.e.mat = MAT.base;
+  a.e.cax = MATCAX; a.e.cay = MATCAY; a.e.caz = MATCAZ;
+  a.e.cbx = MATCBX; a.e.cby = MATCBY; a.e.cbz = MATCBZ;
+  a.e.si = a.si; a.e.sj = a.sj;
+  a.e.cdx = a.C_dx; a.e.cdy = a.C_dy; a.e.cdz = a.C_dz;
 }
 
 void Ecalcmod()
 {
-  int i, j, k, m;
-  double C_dx = dt/(MU_0*EPSILON_0*dx);
-  double C_dy = dt/(MU_0*EPSILON_0*dy);
-  double C_dz = dt/(MU_0*EPSILON_0*dz);
-  double C_MU = dt/(2*EPSILON_0);
-  double JX, JY, JZ;
-
-  for (i=2;i<sx;i++)
-    for (j=2;j<sy;j++)
-      for (k=2;k<sz;k++)
-	{
-	  // Save old E
-	  EX[i][j][k][0] = EX[i][j][k][1];
-	  EY[i][j][k][0] = EY[i][j][k][1];
-	  EZ[i][j][k][0] = EZ[i][j][k][1];
-
-	  // Calculate current from plasma
-	  JX = 0.0;
-	  JY = 0.0;
-	  JZ = 0.0;
-	  for (m=0;m<NS;m++)
-	  {
-	      JX = JX + Q[m] * ( N_0[m] * (UX[i][j][k][2][m] + UX[i-1][j][k][2][m]) +  UX_0 * ( N[i][j][k][2][m] + N[i-1][j][k][2][m]) + 2 * N_0[m] * UX_0 );
-	      JY = JY + Q[m] * ( N_0[m] * (UY[i][j][k][2][m] + UY[i][j-1][k][2][m]) +  UY_0 * ( N[i][j][k][2][m] + N[i][j-1][k][2][m]) + 2 * N_0[m] * UY_0 );
-	      JZ = JZ + Q[m] * ( N_0[m] * (UZ[i][j][k][2][m] + UZ[i][j][k-1][2][m]) +  UZ_0 * ( N[i][j][k][2][m] + N[i][j][k-1][2][m]) + 2 * N_0[m] * UZ_0 );
-	  }
+  EmodArgs a;
+  double start = TILEclock();
+  EmodRow row = Emodselect();
 
+  Emodargs(a);
 
-	  // Calculate the body
-	  // Calculate Ex
-	  EX[i][j][k][1] = EX[i][j][k][0] + ( ( BZ[i][j+1][k][1] - BZ[i][j][k][1] ) * C_dy
-					    - ( BY[i][j][k+1][1] - BY[i][j][k][1] ) * C_dz
-					    - C_MU * SIG[i][j][k] * JX ) * ERX[i][j][k];
-		
-	  // Calculate Ey
-	  EY[i][j][k][1] = EY[i][j][k][0] + ( ( BX[i][j][k+1][1] - BX[i][j][k][1] ) * C_dz
-					    - ( BZ[i+1][j][k][1] - BZ[i][j][k][1] ) * C_dx
-					    - C_MU * SIG[i][j][k] * JY ) * ERY[i][j][k];
-		
-	  // Calculate Ez
-	  EZ[i][j][k][1] = EZ[i][j][k][0] + ( ( BY[i+1][j][k][1] - BY[i][j][k][1] ) * C_dx
-					    - ( BX[i][j+1][k][1] - BX[i][j][k][1] ) * C_dy
-					    - C_MU * SIG[i][j][k] * JZ ) * ERZ[i][j][k];
-	}
+  // E is updated in place, only one time level is kept. Swept tile by tile (tiling.h),
+  // J only on the plasma runs
+  TILEsweep(EX, row, a);
+
+  TILEcount(KERNEL_EMOD, start, (double)(sx-2)*(sy-2)*(sz-2)*(PLASMA_COLD ? EMODC_BYTES : EMOD_BYTES));
+}
+
+// Ecalcmod of the whole k rows of columns [ia,ib) x [ja,jb) (fused sweep, temporal.h),
+// serial as Erows
+void Emodrows(int ia, int ib, int ja, int jb)
+{
+  int i, j;
+  EmodArgs a;
+  EmodRow row = Emodselect();
+
+  Emodargs(a);
+  for (i=ia;i<ib;i++)
+    for (j=ja;j<jb;j++)
+      row(a, EX.index(i,j,2), sz-2);
+}
+
+// Compulsory bytes per cell of Pcalc, those of the separate U and N sweeps
+static int PLASMAbytes()
+{
+  if (PLASMA_COLD == 0)
+    return U_BYTES+N_BYTES;
+  return UC_BYTES + (PLASMA_DENSITY ? NC_BYTES : 0);
 }
 
 void Pcalc()
 {
+  int m;
+  double start = TILEclock();
+
   // U
-  Ucalc();
-  UBCcalc();
-  // N
-  Ncalc();
-  NBCcalc();
+  for (m=0;m<NS;m++)
+    {
+      rotatefields(UX[m]);              // Save Old Values ([0] <- [1] <- [2])
+      rotatefields(UY[m]);
+      rotatefields(UZ[m]);
+    }
+  if (PLASMA_DENSITY == 0)
+    {
+      // No N to advance (PLASMAcold)
+      Ucalc();
+      UBCcalc();
+    }
+  else if (FUSE == 1)
+    {
+      // N is rotated first, then U and N in one pass (UNcalc)
+      for (m=0;m<NS;m++)
+	rotatefields(N[m]);
+      UNcalc();
+      UBCcalc();
+      NBCcalc();
+    }
+  else
+    {
+      Ucalc();
+      UBCcalc();
+      // N
+      for (m=0;m<NS;m++)
+	rotatefields(N[m]);
+      Ncalc();
+      NBCcalc();
+    }
+
+  TILEcount(KERNEL_PLASMA, start, (double)(sx-7)*(sy-7)*(sz-7)*PLASMAbytes());
 }
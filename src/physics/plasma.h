@@ -1,13 +1,23 @@
 #ifndef PLASMA_H
 #define PLASMA_H
 
+#include "../utils/types.h"
+#include "../fields/material.h"
+
 //Defaults
 #define ME 9.1066e-31                           // Mass of electron
 #define QE -1.6021917e-19                       // Charge of electron
 #define AMU 1.6605e-27                          // AMU -> kg
 #define K 1.380622e-23                          // Boltzmans Constant
 
-#define NS 3                                    // Number of species (NS=1 is only electrons)
+#define NS_MAX 4                                // Species counts with unrolled plasma kernels (1..NS_MAX)
+#define EMOD_BYTES (9*EB_BYTES+1+4*8*NS)        // Ecalcmod per cell: Ecalc plus U and N of every species
+#define U_BYTES (9*EB_BYTES+10*8*NS)            // Ucalc per cell: both B levels, E, U history read, U written, N read
+#define N_BYTES (6*8*NS)                        // Ncalc per cell: U, N history read, N written
+#define UN_BYTES (9*EB_BYTES+12*8*NS)           // UNcalc per cell: U[1] and the newest N are read once for both
+#define EMODC_BYTES (9*EB_BYTES+1+3*8*NS)       // Ecalcmod of a cold, drift free plasma (PLASMAcold): no N
+#define UC_BYTES (3*EB_BYTES+9*8*NS)            // Ucalc of a cold, drift free plasma: E and U only
+#define NC_BYTES (5*8*NS)                       // Its Ncalc (density output only): U, N[0] read, N written
 
 // Global Variables (Extern)
 extern double FREQ_PLASMA;
@@ -20,32 +30,36 @@ extern double UY_0;
 extern double UZ_0;
 extern double T;
 extern double Charge;
+extern int NS;                                  // Number of species (NS=1 is only electrons), from the species table
+extern int PLASMA_COLD;                         // T = 0 and no drift, N is not read by U or E (PLASMAcold)
+extern int PLASMA_DENSITY;                      // N is allocated and advanced
 
-extern double N_0[NS];                                 // initial density of species 
-extern double M[NS];                                   // Array of masses for species
-extern double Q[NS];                                   // Array of charges for species
+extern double *N_0;                                    // initial density of species [NS]
+extern double *M;                                      // Array of masses for species [NS]
+extern double *Q;                                      // Array of charges for species [NS]
 
-extern double *****UX, *****UY, *****UZ;	        // Partical Movement NOTE: [x][y][z][time][species:0=electron,1+=ions] 1/26/05
-extern double *****N;					// Density (same as UX)
-extern double ***SIG;					// Conductivity (used to define plasma field)
-extern double ***QF;                                   // Charging Factor (for electrons only
+extern Field (*UX)[3], (*UY)[3], (*UZ)[3];	// Partical Movement NOTE: [species:0=electron,1+=ions][time](x,y,z), time levels rotated by Pcalc
+extern Field (*N)[3];					// Density (same as UX)
 
 // Externs for Field Arrays used in plasma.cpp
-extern double ****EX, ****EY, ****EZ;
-extern double ****BX, ****BY, ****BZ;
-extern double ***ERX, ***ERY, ***ERZ;
+extern EBField EX, EY, EZ;
+extern EBField BX, BY, BZ;
+extern EBField BXP, BYP, BZP;
 extern double dt, dx, dy, dz;
 extern int sx, sy, sz;
 
 // Function Prototypes
-int PLASMAallocate(int allocate);
+int PLASMAspecies(int n, const double *mass, const double *charge, const double *pop);
+void PLASMAcold(int on, int density);
+void PLASMAallocate();
 void PLASMAclear();
-void PLASMAfree();
 
 void Ninital();
 void Ucalc();
 void Ncalc();
+void UNcalc();                                  // Ucalc and Ncalc in one pass (Pcalc)
 void Ecalcmod();
+void Emodrows(int ia, int ib, int ja, int jb);
 void Pcalc();
 void UBCcalc();
 void NBCcalc();
@@ -34,7 +34,8 @@ double Q[NS];                                   // Array of charges for species
 
 double *****UX, *****UY, *****UZ;	        // Partical Movement NOTE: [x][y][z][time][species:0=electron,1+=ions] 1/26/05
 double *****N;					// Density (same as UX)
-double *****N_0;				// Ambient Density (same as UX)
+double ***N_0;					// Ambient Density profile [x][y][z], shared by all time levels and species
+double NPOP[NS];                                // Population scale of the ambient profile for each species
 double ***SIG;					// Conductivity (used to define plasma field)
 double ***QF;                                   // Charging Factor (for electrons only
 
@@ -55,8 +56,9 @@ int PLASMAallocate(int allocate)
   UY = darray5(1, sx, 1, sy, 1, sz, 0, 2, 0, NS-1);
   UZ = darray5(1, sx, 1, sy, 1, sz, 0, 2, 0, NS-1);
   N = darray5(1, sx, 1, sy, 1, sz, 0, 2, 0, NS-1);
-  N_0 = darray5(1, sx, 1, sy, 1, sz, 0, 2, 0, NS-1);
   allocate = allocate + 8*size;
+  N_0 = darray3(1, sx, 1, sy, 1, sz);
+  allocate = allocate + sx*sy*sz*sizeof(double);
   SIG = darray3(1, sx, 1, sy, 1, sz);
   allocate = allocate + 1*size;
   QF = darray3(1, sx, 1, sy, 1, sz);
@@ -108,6 +110,12 @@ void PLASMAclear()
 
 
 N_00[0]=4.00000000*PI*PI*FREQ_PLASMA*FREQ_PLASMA*ME*EPSILON_0/QE/QE; // Ambient electron density 
+  // The ambient fill below gives every species the same profile (the old N_0*pop[m] product was
+  // overwritten for every cell), so the species scale defaults to 1. Set NPOP[m] = pop[m] for a
+  // quasi-neutral mix.
+  for (m=0;m<NS;m++)
+    NPOP[m] = 1.0;
+
 if (NS > 0)
        for (m=1;m<NS;m++)
 	   {
@@ -126,8 +134,7 @@ for(i=1;i<=sx;i++)
 	UY[i][j][k][l][m] = 0.0;
 	UZ[i][j][k][l][m] = 0.0;
 	N[i][j][k][l][m] = 0.0;
-	N_0[i][j][k][l][m] = N_0[i][j][k][l][0]*pop[m]; 
-	N_0[i][j][k][l][m] = N_00[0];
+	N_0[i][j][k] = N_00[0];
         }
 ////////////////////////////////////////////////////////////////////////////////////////////////
 //////////Cone section.
@@ -161,7 +168,6 @@ for (i=1;i<=Xx;i++)
 	    {
 		for (m=0;m<NS;m++)
 		{		   
-		    N_0[i][j][k][l][m] = N_0[i][j][k][l][0]*pop[m]; 	
 		 	if (j== c2 && k==c1 )
 			theta = 0;                    // Undefined..??
 			else if (j==c2)
@@ -173,7 +179,7 @@ for (i=1;i<=Xx;i++)
            	    r= (float) sqrt((j-c2)*(j-c2) + (k-c1)*(k-c1)); //////Distance of present location.	
 		    	if (r<=R && r>(R-1)) 	//// Test to determine cells lying within one cell width of R.
 			{
-			     N_0[i][j][k][l][m] = (double) N_00[0]*2*(R+1)/(Rad+1); ////With decreasing R the density drops from 2No:--- No/2.
+			     N_0[i][j][k] = (double) N_00[0]*2*(R+1)/(Rad+1); ////With decreasing R the density drops from 2No:--- No/2.
 			}			
 		}		
 	      SIG[i][j][k] = 0;
@@ -200,7 +206,7 @@ void PLASMAfree()
   freedarray5(N, 1, sx, 1, sy, 1, sz, 0, 2, 0, 2);
   freedarray3(SIG, 1, sx, 1, sy, 1, sz);
   freedarray3(QF, 1, sx, 1, sy, 1, sz);
-  freedarray5(N_0, 1, sx, 1, sy, 1, sz, 0, 2, 0, 2);
+  freedarray3(N_0, 1, sx, 1, sy, 1, sz);
 
 }
 
@@ -253,21 +259,21 @@ void Ucalc()
 							         + Q[m]*C_U_1 * ( UY[i][j][k][1][m] * BZ_0 + UY_0 * ABZ
 										- UZ[i][j][k][1][m] * BY_0 - UZ_0 * ABY
 										+ EeX) )
-						  - C_U_TX * ( N[i+1][j][k][2][m] - N[i-1][j][k][2][m] ) / N_0[i][j][k][0][m] ) / M[m]
+						  - C_U_TX * ( N[i+1][j][k][2][m] - N[i-1][j][k][2][m] ) / ( N_0[i][j][k]*NPOP[m] ) ) / M[m]
 	                    - C_U_2 * FREQ_COL * FREQ_PLASMA * ( UX[i][j][k][1][m] - UX_0 );
 	  // Calculate UY
 	  UY[i][j][k][2][m] = UY[i][j][k][0][m] + (QF[i][j][k] * (Q[m]*dt * ( EY[i][j][k][1] + EY[i][j+1][k][1] )
 								 + Q[m]*C_U_1 * ( UZ[i][j][k][1][m] * BX_0 + UZ_0 * ABX
 										- UX[i][j][k][1][m] * BZ_0 - UX_0 * ABZ
 								                + EeY) )
-						  - C_U_TY * ( N[i][j+1][k][2][m] - N[i][j-1][k][2][m] ) / N_0[i][j][k][0][m] ) / M[m]
+						  - C_U_TY * ( N[i][j+1][k][2][m] - N[i][j-1][k][2][m] ) / ( N_0[i][j][k]*NPOP[m] ) ) / M[m]
 	                    - C_U_2 * FREQ_COL * FREQ_PLASMA * ( UY[i][j][k][1][m] - UY_0 );
 	  // Calculate UZ
 	  UZ[i][j][k][2][m] = UZ[i][j][k][0][m] + (QF[i][j][k] * (Q[m]*dt * ( EZ[i][j][k][1] + EZ[i][j][k+1][1] )
 								 + Q[m]*C_U_1 * ( UX[i][j][k][1][m] * BY_0 + UX_0 * ABY
 										- UY[i][j][k][1][m] * BX_0 - UY_0 * ABX
 										+ EeZ ) )
-						  - C_U_TZ * ( N[i][j][k+1][2][m] - N[i][j][k-1][2][m] ) / N_0[i][j][k][0][m] ) / M[m]
+						  - C_U_TZ * ( N[i][j][k+1][2][m] - N[i][j][k-1][2][m] ) / ( N_0[i][j][k]*NPOP[m] ) ) / M[m]
 	                    - C_U_2 * FREQ_COL * FREQ_PLASMA * ( UZ[i][j][k][1][m] - UZ_0 );
 	}
 
@@ -301,7 +307,7 @@ void Ncalc()
                 if (k<sz-5)
 			{
                        //N_0[m]=N_00[m];
-                        N[i][j][k][2][m] = N[i][j][k][0][m] - ( N_0[i][j][k][1][m] * ( ( UX[i+1][j][k][1][m] - UX[i-1][j][k][1][m] ) * C_N_tx
+                        N[i][j][k][2][m] = N[i][j][k][0][m] - ( ( N_0[i][j][k]*NPOP[m] ) * ( ( UX[i+1][j][k][1][m] - UX[i-1][j][k][1][m] ) * C_N_tx
 								 + ( UY[i][j+1][k][1][m] - UY[i][j-1][k][1][m] ) * C_N_ty
 								 + ( UZ[i][j][k+1][1][m] - UZ[i][j][k-1][1][m] ) * C_N_tz )
 						      + UX_0 * ( N[i+1][j][k][1][m] - N[i-1][j][k][1][m] ) * C_N_tx
@@ -310,7 +316,7 @@ void Ncalc()
 			}
 		else
                         {
-			N[i][j][k][2][m] = N[i][j][k][0][m] - ( N_0[i][j][k][1][m] * ( ( UX[i+1][j][k][1][m] - UX[i-1][j][k][1][m] ) * C_N_tx
+			N[i][j][k][2][m] = N[i][j][k][0][m] - ( ( N_0[i][j][k]*NPOP[m] ) * ( ( UX[i+1][j][k][1][m] - UX[i-1][j][k][1][m] ) * C_N_tx
 								 + ( UY[i][j+1][k][1][m] - UY[i][j-1][k][1][m] ) * C_N_ty
 								 + ( UZ[i][j][k+1][1][m] - UZ[i][j][k-1][1][m] ) * C_N_tz )
 						      + UX_0 * ( N[i+1][j][k][1][m] - N[i-1][j][k][1][m] ) * C_N_tx
@@ -351,9 +357,9 @@ void Ecalcmod()
 	  JZ = 0.0;
 	  for (m=0;m<NS;m++)
 	  {
-	      JX = JX + Q[m] * ( N_0[i][j][k][0][m] * (UX[i][j][k][2][m] + UX[i-1][j][k][2][m]) +  UX_0 * ( N[i][j][k][2][m] + N[i-1][j][k][2][m]) + 2 * N_0[i][j][k][0][m] * UX_0 );
-	      JY = JY + Q[m] * ( N_0[i][j][k][0][m] * (UY[i][j][k][2][m] + UY[i][j-1][k][2][m]) +  UY_0 * ( N[i][j][k][2][m] + N[i][j-1][k][2][m]) + 2 * N_0[i][j][k][0][m] * UY_0 );
-	      JZ = JZ + Q[m] * ( N_0[i][j][k][0][m] * (UZ[i][j][k][2][m] + UZ[i][j][k-1][2][m]) +  UZ_0 * ( N[i][j][k][2][m] + N[i][j][k-1][2][m]) + 2 * N_0[i][j][k][0][m] * UZ_0 );
+	      JX = JX + Q[m] * ( ( N_0[i][j][k]*NPOP[m] ) * (UX[i][j][k][2][m] + UX[i-1][j][k][2][m]) +  UX_0 * ( N[i][j][k][2][m] + N[i-1][j][k][2][m]) + 2 * ( N_0[i][j][k]*NPOP[m] ) * UX_0 );
+	      JY = JY + Q[m] * ( ( N_0[i][j][k]*NPOP[m] ) * (UY[i][j][k][2][m] + UY[i][j-1][k][2][m]) +  UY_0 * ( N[i][j][k][2][m] + N[i][j-1][k][2][m]) + 2 * ( N_0[i][j][k]*NPOP[m] ) * UY_0 );
+	      JZ = JZ + Q[m] * ( ( N_0[i][j][k]*NPOP[m] ) * (UZ[i][j][k][2][m] + UZ[i][j][k-1][2][m]) +  UZ_0 * ( N[i][j][k][2][m] + N[i][j][k-1][2][m]) + 2 * ( N_0[i][j][k]*NPOP[m] ) * UZ_0 );
 	  }
 
 
@@ -8,8 +8,8 @@
 extern int **Sloc;
 extern double *Spar;
 extern double dt, dx, dy, dz, df;
-extern double ****EX, ****EY, ****EZ;
-extern double ****BX, ****BY, ****BZ;
+extern EBField EX, EY, EZ;
+extern EBField BX, BY, BZ;
 extern double *VOLT, *CURRENT;
 
 void Esource(double timev, int a)
@@ -75,14 +75,15 @@ void Esource(double timev, int a)
 
   // orentation of source
   if (Sloc[a][3] == 1)
-    EX[Sloc[a][0]][Sloc[a][1]][Sloc[a][2]][1] = value / dx;
+    EX(Sloc[a][0],Sloc[a][1],Sloc[a][2]) = value / dx;
   if (Sloc[a][3] == 2)
-    EY[Sloc[a][0]][Sloc[a][1]][Sloc[a][2]][1] = value / dy;
+    EY(Sloc[a][0],Sloc[a][1],Sloc[a][2]) = value / dy;
   if (Sloc[a][3] == 3)
-    EZ[Sloc[a][0]][Sloc[a][1]][Sloc[a][2]][1] = value / dz;
+    EZ(Sloc[a][0],Sloc[a][1],Sloc[a][2]) = value / dz;
 
 }
 
+// Voltage and current of source a, summed in double whatever the field storage (types.h)
 void Rcalc( int a)
 {
   int x, y, z;
@@ -94,24 +95,24 @@ void Rcalc( int a)
 	
   if (Sloc[a][3] == 1)
     {
-      CURRENT[a] = ( ( BY[x][y][z][1] - BY[x][y][z+1][1] ) * dx
-		    + ( BZ[x][y+1][z][1] - BZ[x][y][z][1] ) * dy ) / MU_0;
+      CURRENT[a] = ( ( (double)BY(x,y,z) - BY(x,y,z+1) ) * dx
+		    + ( (double)BZ(x,y+1,z) - BZ(x,y,z) ) * dy ) / MU_0;
       // ASSUMING THE CURRENT / VOLTAGE VARIES SLOWLY COMPARD TO dt
-      VOLT[a] = - EX[x][y][z][1] * dx;
+      VOLT[a] = - EX(x,y,z) * dx;
     }
   if (Sloc[a][3] == 2)
     {
-      CURRENT[a] = ( ( BX[x][y][z+1][1] - BX[x][y][z][1] ) * dx
-		    + ( BZ[x][y][z][1] - BZ[x+1][y][z][1] ) * dy ) / MU_0;
+      CURRENT[a] = ( ( (double)BX(x,y,z+1) - BX(x,y,z) ) * dx
+		    + ( (double)BZ(x,y,z) - BZ(x+1,y,z) ) * dy ) / MU_0;
       // ASSUMING THE CURRENT / VOLTAGE VARIES SLOWLY COMPARD TO dt
-      VOLT[a] = - EY[x][y][z][1] * dy;
+      VOLT[a] = - EY(x,y,z) * dy;
     }
   if (Sloc[a][3] == 3)
     {
-      CURRENT[a] = ( ( BX[x][y][z][1] - BX[x][y+1][z][1] ) * dx
-		    + ( BY[x+1][y][z][1] - BY[x][y][z][1] ) * dy ) / MU_0;
+      CURRENT[a] = ( ( (double)BX(x,y,z) - BX(x,y+1,z) ) * dx
+		    + ( (double)BY(x+1,y,z) - BY(x,y,z) ) * dy ) / MU_0;
       // ASSUMING THE CURRENT / VOLTAGE VARIES SLOWLY COMPARD TO dt
-      VOLT[a] = - EZ[x][y][z][1] * dz;
+      VOLT[a] = - EZ(x,y,z) * dz;
     }
 
 }
@@ -3,6 +3,7 @@
 
 #include <math.h>
 #include "../utils/constants.h"
+#include "../utils/types.h"
 
 // Function Prototypes
 void Esource(double timev, int a);
@@ -2,6 +2,13 @@
 #include <malloc.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
 
 #define NR_END 1
 #define FREE_ARG char*
@@ -400,3 +407,305 @@ void freedarray5(double *****A, int x1, int x2, int y1, int y2, int z1, int z2,
   free((FREE_ARG) (A[x1]+y1-NR_END));
   free((FREE_ARG) (A+x1-NR_END));
 }
+
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Aligned block for flat fields /
+//////////////////////////////////
+void *falloc(size_t bytes)
+{
+  void *A;
+
+  if (bytes == 0)
+    bytes = FIELD_ALIGN;
+#ifdef _MSC_VER
+  A = _aligned_malloc(bytes, FIELD_ALIGN);
+#else
+  if (posix_memalign(&A, FIELD_ALIGN, bytes) != 0)
+    A = NULL;
+#endif
+  if (!A)
+    {
+      printf("Error in Allocating Memory");
+      exit(2);
+    }
+  return A;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Frees aligned block /
+////////////////////////
+void ffree(void *A)
+{
+#ifdef _MSC_VER
+  _aligned_free(A);
+#else
+  free(A);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Grid padding /
+/////////////////
+// With dense extents the power of two meshes (64, 128, 256, ...) have j and i strides
+// that are multiples of the L1 way size (4 KB, 64 sets of 64 byte lines). The stencil
+// reads at c, c+sj and c+si then fall into the same cache set and evict each other.
+// The k extent is padded to whole cache lines of doubles (every row starts SIMD aligned),
+// plus one line if that is a multiple of the way size, and the j extent is made odd.
+// Neither stride is then a multiple of the way size. Only grid (rank 3) fields are padded.
+#define PAD_LINE (FIELD_ALIGN/sizeof(double))   // Doubles per cache line
+#define PAD_WAY (4096/FIELD_ALIGN)              // Cache lines per L1 way
+
+static int field_pad = 1;
+
+void fieldpadding(int on)
+{
+  field_pad = on;
+}
+
+long fieldextent(int rank, int d, long n)
+{
+  if ((field_pad == 0) || (rank != 3))
+    return n;
+  switch (d)
+    {
+    case 2:                                     // k: whole lines, not a whole way
+      n = (n + PAD_LINE - 1) / PAD_LINE * PAD_LINE;
+      if ((n / PAD_LINE) % PAD_WAY == 0)
+	n += PAD_LINE;
+      return n;
+    case 1:                                     // j: odd
+      return (n % 2 == 0) ? n+1 : n;
+    default:
+      return n;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// 3D, 4D and 5D flat fields of doubles (same bounds as darray3/4/5) /
+//////////////////////////////////////////////////////////////////////
+Field field3(int x1, int x2, int y1, int y2, int z1, int z2, const char *name)
+{
+  int lo[3] = {x1, y1, z1};
+  int hi[3] = {x2, y2, z2};
+
+  return fieldalloc<double>(3, lo, hi, name);
+}
+
+Field field4(int x1, int x2, int y1, int y2, int z1, int z2, int m1, int m2, const char *name)
+{
+  int lo[4] = {x1, y1, z1, m1};
+  int hi[4] = {x2, y2, z2, m2};
+
+  return fieldalloc<double>(4, lo, hi, name);
+}
+
+Field field5(int x1, int x2, int y1, int y2, int z1, int z2, int m1, int m2, int n1, int n2, const char *name)
+{
+  int lo[5] = {x1, y1, z1, m1, n1};
+  int hi[5] = {x2, y2, z2, m2, n2};
+
+  return fieldalloc<double>(5, lo, hi, name);
+}
+
+// The same for the E/B fields and the Mur history (ebreal, see types.h)
+EBField ebfield3(int x1, int x2, int y1, int y2, int z1, int z2, const char *name)
+{
+  int lo[3] = {x1, y1, z1};
+  int hi[3] = {x2, y2, z2};
+
+  return fieldalloc<ebreal>(3, lo, hi, name);
+}
+
+EBField ebfield4(int x1, int x2, int y1, int y2, int z1, int z2, int m1, int m2, const char *name)
+{
+  int lo[4] = {x1, y1, z1, m1};
+  int hi[4] = {x2, y2, z2, m2};
+
+  return fieldalloc<ebreal>(4, lo, hi, name);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Simulation arena /
+/////////////////////
+// All field, boundary and plasma arrays are carved out of one aligned reservation.
+// The allocation routines are run twice: once after arenaplan(), where aalloc only
+// counts (and returns NULL), and again after arenareserve() has made the reservation.
+// Sizes are kept exactly, in 64 bit, per array name and in total.
+#define ARENA_NAMES 64                          // Distinct array names tracked in the report
+#define ARENA_ALIGN (2*1024*1024)               // Reservation alignment (one x86-64 huge page)
+
+static int arena_mode = 0;                      // 0 = off (standalone falloc), 1 = planning, 2 = carving
+static char *arena_block = NULL;                // The reservation
+static unsigned long long arena_size = 0;       // Bytes reserved
+static unsigned long long arena_used = 0;       // Bytes counted (planning) or carved (carving)
+static int arena_n = 0;                         // Number of names in the report
+static const char *arena_name[ARENA_NAMES];     // Array name
+static int arena_count[ARENA_NAMES];            // Number of arrays with that name
+static unsigned long long arena_bytes[ARENA_NAMES]; // Bytes used by arrays with that name
+
+// Rounds up to the next FIELD_ALIGN boundary so every array starts on a cache line, plus
+// one spare line. Grid arrays are often a whole number of 4 KB ways long, and without the
+// spare line the same cell of every array would map to the same cache set.
+static unsigned long long arenaround(unsigned long long bytes)
+{
+  return (bytes + FIELD_ALIGN - 1) / FIELD_ALIGN * FIELD_ALIGN + FIELD_ALIGN;
+}
+
+// Adds an array to the per name totals (only counted during planning)
+static void arenarecord(const char *name, unsigned long long bytes)
+{
+  int a;
+
+  if (name == NULL)
+    name = "(unnamed)";
+  for (a=0;a<arena_n;a++)
+    if (strcmp(arena_name[a], name) == 0)
+      break;
+  if (a == arena_n)
+    {
+      if (arena_n == ARENA_NAMES)
+	a = ARENA_NAMES-1;                      // Lump the rest into the last entry
+      else
+	{
+	  arena_name[a] = name;
+	  arena_count[a] = 0;
+	  arena_bytes[a] = 0;
+	  arena_n++;
+	}
+    }
+  arena_count[a]++;
+  arena_bytes[a] += bytes;
+}
+
+void arenaplan()
+{
+  arenarelease();
+  arena_mode = 1;
+  arena_used = 0;
+  arena_n = 0;
+}
+
+// The reservation is huge page aligned and flagged for transparent huge pages. It is
+// not touched here, the clear routines fault it in slab by slab (see SLAB_FOR in types.h)
+static void *arenablock(unsigned long long bytes)
+{
+  void *A;
+
+#ifdef _MSC_VER
+  A = _aligned_malloc((size_t) bytes, ARENA_ALIGN);
+#else
+  if (posix_memalign(&A, ARENA_ALIGN, (size_t) bytes) != 0)
+    A = NULL;
+#endif
+  if (!A)
+    {
+      printf("Error in Allocating Memory");
+      exit(2);
+    }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  madvise(A, (size_t) bytes, MADV_HUGEPAGE);    // Advisory only, ignored when THP is off
+#endif
+  return A;
+}
+
+unsigned long long arenareserve()
+{
+  arena_size = arena_used;
+  arena_block = (char *) arenablock((arena_size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN);
+  arena_used = 0;
+  arena_mode = 2;
+  return arena_size;
+}
+
+void *aalloc(size_t bytes, const char *name)
+{
+  unsigned long long size = arenaround(bytes);
+  void *A;
+
+  switch (arena_mode)
+    {
+    case 1:
+      arenarecord(name, size);
+      arena_used += size;
+      return NULL;
+    case 2:
+      if (arena_used + size > arena_size)
+	{
+	  printf("Error in Allocating Memory (arena exhausted by %s)", name ? name : "(unnamed)");
+	  exit(2);
+	}
+      A = arena_block + arena_used;
+      arena_used += size;
+      return A;
+    default:
+      return falloc(bytes);
+    }
+}
+
+void afree(void *A)
+{
+  if (A == NULL)
+    return;
+  if ((arena_block != NULL) && ((char *) A >= arena_block) && ((char *) A < arena_block + arena_size))
+    return;                                     // Owned by the arena, see arenarelease
+  ffree(A);
+}
+
+void arenarelease()
+{
+  if (arena_block != NULL)
+    ffree(arena_block);
+  arena_block = NULL;
+  arena_size = 0;
+  arena_used = 0;
+  arena_mode = 0;
+}
+
+unsigned long long arenabytes()
+{
+  return (arena_mode == 2) ? arena_size : arena_used;
+}
+
+void arenareport()
+{
+  int a;
+
+  printf("\tArray          Count           Bytes\n");
+  for (a=0;a<arena_n;a++)
+    printf("\t%-12s %7d %15llu\n", arena_name[a], arena_count[a], arena_bytes[a]);
+  printf("\tTotal                %15llu (%llu M bytes)\n", arenabytes(), arenabytes() >> 20);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Physical memory available to a new run in bytes (0 if it can not be determined) /
+////////////////////////////////////////////////////////////////////////////////////
+unsigned long long availablememory()
+{
+#if defined(__linux__)
+  FILE *fp;
+  char line[128];
+  unsigned long long kb = 0;
+
+  // MemAvailable includes reclaimable page cache, unlike the free page count
+  if ((fp = fopen("/proc/meminfo", "r")) != NULL)
+    {
+      while (fgets(line, sizeof(line), fp) != NULL)
+	if (sscanf(line, "MemAvailable: %llu kB", &kb) == 1)
+	  break;
+      fclose(fp);
+    }
+  if (kb > 0)
+    return kb*1024;
+  return (unsigned long long) sysconf(_SC_AVPHYS_PAGES) * (unsigned long long) sysconf(_SC_PAGESIZE);
+#elif defined(_WIN32)
+  MEMORYSTATUSEX status;
+
+  status.dwLength = sizeof(status);
+  if (GlobalMemoryStatusEx(&status))
+    return status.ullAvailPhys;
+  return 0;
+#else
+  return 0;
+#endif
+}
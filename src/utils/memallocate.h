@@ -1,6 +1,9 @@
 #ifndef MEMALLOCATE_H
 #define MEMALLOCATE_H
 
+#include <stddef.h>
+#include "types.h"
+
 // Function Prototypes
 double *darray1(int x1, int x2);
 double **darray2(int x1, int x2, int y1, int y2);
@@ -16,4 +19,72 @@ void freedarray3(double ***A, int x1, int x2, int y1, int y2, int z1, int z2);
 void freedarray4(double ****A, int x1, int x2, int y1, int y2, int z1, int z2, int m1, int m2);
 void freedarray5(double *****A, int x1, int x2, int y1, int y2, int z1, int z2, int m1, int m2, int n1, int n2);
 
+// Flat aligned fields (see types.h)
+void *falloc(size_t bytes);
+void ffree(void *A);
+
+// Simulation arena (see memallocate.cpp), every field allocation goes through aalloc
+void arenaplan();                               // Start a planning pass, aalloc only counts
+unsigned long long arenareserve();              // One reservation for everything counted, returns bytes
+void *aalloc(size_t bytes, const char *name);   // Carve from the arena (plain falloc when no arena is active)
+void afree(void *A);                            // Frees a block unless the arena owns it
+void arenarelease();                            // Releases the whole arena
+unsigned long long arenabytes();                // Exact bytes reserved (or counted so far while planning)
+void arenareport();                             // Prints bytes per array name and the total
+unsigned long long availablememory();           // Physical memory available to a new run (0 = unknown)
+
+// Grid padding (see memallocate.cpp), used by fieldalloc
+long fieldextent(int rank, int d, long n);      // Allocated extent of index d holding n elements
+void fieldpadding(int on);                      // 1 = pad grid fields (default), 0 = dense
+
+Field field3(int x1, int x2, int y1, int y2, int z1, int z2, const char *name = NULL);
+Field field4(int x1, int x2, int y1, int y2, int z1, int z2, int m1, int m2, const char *name = NULL);
+Field field5(int x1, int x2, int y1, int y2, int z1, int z2, int m1, int m2, int n1, int n2, const char *name = NULL);
+EBField ebfield3(int x1, int x2, int y1, int y2, int z1, int z2, const char *name = NULL);
+EBField ebfield4(int x1, int x2, int y1, int y2, int z1, int z2, int m1, int m2, const char *name = NULL);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Allocates a flat field of any element type and rank (last index fastest) /
+///////////////////////////////////////////////////////////////////////////////
+// Grid (rank 3) fields have their k and j extents padded by fieldextent. The padding
+// depends only on the bounds, so every grid field of one shape (doubles or bytes)
+// has the same strides and one offset still indexes all of them.
+template <typename T>
+FieldT<T> fieldalloc(int rank, const int *lo, const int *hi, const char *name = NULL)
+{
+  FieldT<T> A;
+  long stride = 1, offset = 0;
+  int d;
+
+  A.rank = rank;
+  for (d=FIELD_MAXDIM-1;d>=0;d--)
+    {
+      if (d >= rank)
+	{
+	  A.lo[d] = 0;
+	  A.hi[d] = 0;
+	  A.s[d] = 0;
+	  continue;
+	}
+      A.lo[d] = lo[d];
+      A.hi[d] = hi[d];
+      A.s[d] = stride;
+      offset += lo[d]*stride;
+      stride *= fieldextent(rank, d, hi[d]-lo[d]+1);
+    }
+  A.count = (size_t) stride;
+  A.data = (T *) aalloc(A.count*sizeof(T), name);
+  A.base = (A.data == NULL) ? NULL : A.data - offset;  // NULL while the arena is only planning
+  return A;
+}
+
+template <typename T>
+void freefield(FieldT<T> &A)
+{
+  afree(A.data);
+  A.data = NULL;
+  A.base = NULL;
+  A.count = 0;
+}
+
 #endif // MEMALLOCATE_H
@@ -1,7 +1,138 @@
 #ifndef TYPES_H
 #define TYPES_H
 
-// Placeholder for future type definitions
-// e.g., structs for Grid, FieldArrays, etc.
+#include <stddef.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define FIELD_ALIGN 64                          // Byte alignment of field storage (one cache line)
+#define FIELD_MAXDIM 5                          // Highest rank handled by FieldT
+
+// Non-aliasing hint for the raw kernel pointers
+#if defined(_MSC_VER) || defined(__GNUC__)
+#define RESTRICT __restrict
+#else
+#define RESTRICT
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Thread slabs /
+/////////////////
+// In OpenMP builds the grid sweeps are split across threads in static slabs of i.
+// The clear routines use the same schedule so every page is first touched (and placed
+// on the NUMA node of) the thread that later updates it. Put SLAB_FOR(...) right before
+// the i loop and list the variables of the inner loops, they are declared at the top
+// of the routines and must be private. Serial builds ignore it.
+//
+// Tiled sweeps (tiling.h) open one region with SLAB_REGION(...) and share the i loop of
+// every tile with SLAB_SHARE. Each tile has the same i range, so every thread keeps the
+// same slab of i for all tiles and there is no barrier between them. Sweeps whose tiles
+// depend on each other (the fused E/B step, temporal.h) order them with SLAB_BARRIER and
+// leave the work on the tile's boundary to one thread with SLAB_SINGLE. SLAB_TILES hands
+// out whole independent tiles (temporal blocks), one at a time, barrier at the end.
+#ifdef _OPENMP
+#define SLAB_STR(...) #__VA_ARGS__
+#define SLAB_FOR(...) _Pragma(SLAB_STR(omp parallel for schedule(static) private(__VA_ARGS__)))
+#define SLAB_REGION(...) _Pragma(SLAB_STR(omp parallel private(__VA_ARGS__)))
+#define SLAB_SHARE _Pragma("omp for schedule(static) nowait")
+#define SLAB_BARRIER _Pragma("omp barrier")
+#define SLAB_SINGLE _Pragma("omp single")
+#define SLAB_TILES _Pragma("omp for schedule(dynamic, 1)")
+#define SLAB_THREADS omp_get_max_threads()      // Number of slabs a sweep is split into
+#define SLAB_THREAD omp_get_thread_num()        // Slab of the calling thread
+#else
+#define SLAB_FOR(...)
+#define SLAB_REGION(...)
+#define SLAB_SHARE
+#define SLAB_BARRIER
+#define SLAB_SINGLE
+#define SLAB_TILES
+#define SLAB_THREADS 1
+#define SLAB_THREAD 0
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// Flat field container /
+/////////////////////////
+// Replaces the pointer tables built by darray3/darray4/darray5. The data is one
+// contiguous, FIELD_ALIGN aligned block in the same index order as the old arrays
+// (last index fastest), so A(i,j,k,l,m) is base[i*s[0] + j*s[1] + k*s[2] + l*s[3] + m*s[4]].
+// base is shifted so that the lower bounds given at allocation index directly,
+// i.e. the 1-based grid loops keep their bounds.
+//
+// Kernels should not go through operator() in the inner loop; take base (or the
+// pointer to a fixed time level / species, see level()) and the strides once and
+// step a linear offset instead.
+template <typename T>
+struct FieldT
+{
+  T *data;                                      // Start of the aligned allocation (NULL when empty)
+  T *base;                                      // data shifted so lower bounds map to data[0]
+  long s[FIELD_MAXDIM];                         // Stride of each index in elements (unused -> 0)
+  int lo[FIELD_MAXDIM];                         // Lower bound of each index
+  int hi[FIELD_MAXDIM];                         // Upper bound of each index
+  int rank;                                     // Number of indices in use
+  size_t count;                                 // Number of elements in data
+
+  T &operator()(int i, int j, int k) const
+  { return base[i*s[0] + j*s[1] + k*s[2]]; }
+  T &operator()(int i, int j, int k, int l) const
+  { return base[i*s[0] + j*s[1] + k*s[2] + l*s[3]]; }
+  T &operator()(int i, int j, int k, int l, int m) const
+  { return base[i*s[0] + j*s[1] + k*s[2] + l*s[3] + m*s[4]]; }
+
+  // Linear offset of the spatial point (i,j,k) relative to base
+  long index(int i, int j, int k) const
+  { return i*s[0] + j*s[1] + k*s[2]; }
+
+  // Base pointer with the trailing indices fixed, so that p[index(i,j,k)] == A(i,j,k,l[,m])
+  T *level(int l) const
+  { return base + l*s[3]; }
+  T *level(int l, int m) const
+  { return base + l*s[3] + m*s[4]; }
+
+  size_t bytes() const
+  { return count*sizeof(T); }
+};
+
+typedef FieldT<double> Field;
+typedef FieldT<unsigned char> IdField;         // One byte per cell (material IDs)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// E/B storage precision /
+//////////////////////////
+// EX..BZP and the Mur history are ebreal fields. Builds with FIELD_FLOAT (CMake option
+// PFFDTD_FLOAT_FIELDS) store them as float, which halves the traffic of the E/B sweeps.
+// Only the storage changes: the kernels load the floats into doubles, do every multiply
+// and add in double and round once on the store, and VOLT/CURRENT, the plasma and the
+// coefficient tables stay double. The default build is double throughout.
+#ifdef FIELD_FLOAT
+typedef float ebreal;
+#else
+typedef double ebreal;
+#endif
+typedef FieldT<ebreal> EBField;
+#define EB_BYTES ((int)sizeof(ebreal))          // Bytes of one E/B value (the *_BYTES traffic counts)
+
+// Exchanges two fields of the same shape by pointer (used to flip time levels)
+template <typename T>
+inline void swapfields(FieldT<T> &A, FieldT<T> &B)
+{
+  FieldT<T> tmp = A;
+  A = B;
+  B = tmp;
+}
+
+// Advances a three level time history by pointer: [0] <- [1] <- [2], and the
+// oldest buffer becomes [2], ready to receive the new values
+template <typename T>
+inline void rotatefields(FieldT<T> A[3])
+{
+  FieldT<T> tmp = A[0];
+  A[0] = A[1];
+  A[1] = A[2];
+  A[2] = tmp;
+}
 
 #endif // TYPES_H
@@ -0,0 +1,99 @@
+// Grid padding benchmark
+//
+// Times the Ecalc/Bcalc stencils (c, c+1, c+sj, c+si reads) on dense and padded grid
+// fields for the dipole grid and power of two meshes. Conflict misses show up as a
+// higher time per cell on the dense layout; the padded layout should be flat across
+// sizes. Usage: bench_padding [sweeps]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "utils/memallocate.h"
+
+// Runs one E and one B sweep (same stencil and stride use as Ecalc/Bcalc)
+static void sweep(Field *E, Field *B, int sx, int sy, int sz)
+{
+  int i, j, k;
+  long c;
+  double *RESTRICT ex = E[0].base, *RESTRICT ey = E[1].base, *RESTRICT ez = E[2].base;
+  double *RESTRICT bx = B[0].base, *RESTRICT by = B[1].base, *RESTRICT bz = B[2].base;
+  const long si = E[0].s[0], sj = E[0].s[1];
+
+  for (i=2;i<sx;i++)
+    for (j=2;j<sy;j++)
+      {
+	c = E[0].index(i,j,2);
+	for (k=2;k<sz;k++,c++)
+	  {
+	    ex[c] = ex[c] + ( ( bz[c+sj] - bz[c] ) * 0.1 - ( by[c+1] - by[c] ) * 0.1 );
+	    ey[c] = ey[c] + ( ( bx[c+1] - bx[c] ) * 0.1 - ( bz[c+si] - bz[c] ) * 0.1 );
+	    ez[c] = ez[c] + ( ( by[c+si] - by[c] ) * 0.1 - ( bx[c+sj] - bx[c] ) * 0.1 );
+	  }
+      }
+  for (i=2;i<sx;i++)
+    for (j=2;j<sy;j++)
+      {
+	c = B[0].index(i,j,2);
+	for (k=2;k<sz;k++,c++)
+	  {
+	    bx[c] = bx[c] + ( ( ey[c] - ey[c-1] ) * 0.1 - ( ez[c] - ez[c-sj] ) * 0.1 );
+	    by[c] = by[c] + ( ( ez[c] - ez[c-si] ) * 0.1 - ( ex[c] - ex[c-1] ) * 0.1 );
+	    bz[c] = bz[c] + ( ( ex[c] - ex[c-sj] ) * 0.1 - ( ey[c] - ey[c-si] ) * 0.1 );
+	  }
+      }
+}
+
+// Returns ns per cell update (E and B) for one layout
+static double run(int sx, int sy, int sz, int pad, int sweeps, long *sj, long *si)
+{
+  Field E[3], B[3];
+  int a, i, j, k, n;
+  clock_t start;
+  double t;
+
+  fieldpadding(pad);
+  for (a=0;a<3;a++)
+    {
+      E[a] = field3(1, sx, 1, sy, 1, sz);
+      B[a] = field3(1, sx, 1, sy, 1, sz);
+      for (i=1;i<=sx;i++)
+	for (j=1;j<=sy;j++)
+	  for (k=1;k<=sz;k++)
+	    {
+	      E[a](i,j,k) = 0;
+	      B[a](i,j,k) = 1e-3*((i+j+k+a) % 7);
+	    }
+    }
+  *sj = E[0].s[1];
+  *si = E[0].s[0];
+  sweep(E, B, sx, sy, sz);                      // warm up
+  start = clock();
+  for (n=0;n<sweeps;n++)
+    sweep(E, B, sx, sy, sz);
+  t = (double)(clock() - start) / CLOCKS_PER_SEC;
+  for (a=0;a<3;a++)
+    {
+      freefield(E[a]);
+      freefield(B[a]);
+    }
+  fieldpadding(1);
+  return 1e9 * t / ((double)sweeps * (sx-2) * (sy-2) * (sz-2));
+}
+
+int main(int argc, char *argv[])
+{
+  int grids[][3] = { {70, 70, 65}, {64, 64, 64}, {128, 128, 128}, {256, 256, 64} };
+  int g, sweeps = (argc > 1) ? atoi(argv[1]) : 20;
+  long sj0, si0, sj1, si1;
+  double t0, t1;
+
+  printf("Grid            dense sj/si     ns/cell   padded sj/si     ns/cell   speedup\n");
+  for (g=0;g<(int)(sizeof(grids)/sizeof(grids[0]));g++)
+    {
+      t0 = run(grids[g][0], grids[g][1], grids[g][2], 0, sweeps, &sj0, &si0);
+      t1 = run(grids[g][0], grids[g][1], grids[g][2], 1, sweeps, &sj1, &si1);
+      printf("%4dx%4dx%4d %5ld/%-8ld %8.3f   %5ld/%-8ld %8.3f   %6.2fx\n",
+	     grids[g][0], grids[g][1], grids[g][2], sj0, si0, t0, sj1, si1, t1, t0/t1);
+    }
+  return 0;
+}
@@ -1,25 +1,28 @@
 @echo off
 REM Regression Test Runner
-REM 1. Compiles the code (requires g++ in PATH)
+REM 1. Compiles the code through CMake (requires cmake and a C++ compiler in PATH),
+REM    so the source list and the per-file kernel flags come from CMakeLists.txt
 REM 2. Runs the dipole simulation
 REM 3. Compares output against golden data
 
 pushd %~dp0..\..
 
 echo [1/3] Compiling PFFDTD...
-g++ -std=c++11 -O3 src/pffdtd.cpp src/utils/memallocate.cpp src/io/file_handler.cpp src/io/output.cpp src/source/source.cpp src/fields/field_calculator.cpp src/physics/plasma.cpp -o pffdtd.exe
-if %ERRORLEVEL% NEQ 0 (
-    echo Compilation failed! Make sure g++ is in your PATH.
-    popd
-    exit /b 1
-)
+cmake -S . -B build_regression -DCMAKE_BUILD_TYPE=Release -DPFFDTD_BUILD_TESTS=OFF
+if %ERRORLEVEL% NEQ 0 goto buildfail
+cmake --build build_regression --config Release --target pffdtd_release
+if %ERRORLEVEL% NEQ 0 goto buildfail
+
+REM Multi-config generators (Visual Studio) add a per-config directory
+set PFFDTD=build_regression\bin\release\pffdtd_release.exe
+if exist build_regression\bin\release\Release\pffdtd_release.exe set PFFDTD=build_regression\bin\release\Release\pffdtd_release.exe
 
 echo [2/3] Running Simulation...
 if not exist tests\regression\output mkdir tests\regression\output
 
 REM Run with dipole input
 REM Usage: pffdtd <input_file> <output_prefix>
-pffdtd.exe dipole tests\regression\output\dipole_test
+%PFFDTD% dipole tests\regression\output\dipole_test
 
 if %ERRORLEVEL% NEQ 0 (
     echo Simulation failed!
@@ -37,4 +40,10 @@ if %ERRORLEVEL% NEQ 0 (
 ) else (
     echo ALL TESTS PASSED
     popd
+    exit /b 0
 )
+
+:buildfail
+echo Compilation failed! Make sure cmake and a C++ compiler are in your PATH.
+popd
+exit /b 1
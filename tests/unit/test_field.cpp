@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include "utils/memallocate.h"
+
+TEST(FieldTest, AlignedAndContiguous) {
+    Field A = field4(1, 7, 1, 5, 1, 3, 0, 1);
+    EXPECT_EQ((uintptr_t)A.data % FIELD_ALIGN, 0u);
+    EXPECT_EQ(A.count, (size_t)(7*5*3*2));
+    EXPECT_EQ(&A(1,1,1,0), A.data);
+    EXPECT_EQ(&A(7,5,3,1), A.data + A.count - 1);
+    freefield(A);
+    EXPECT_TRUE(A.data == NULL);
+}
+
+TEST(FieldTest, SameOrderAsDarray) {
+    // Last index fastest, exactly like the darray pointer tables
+    Field A = field5(1, 4, 1, 3, 1, 2, 0, 2, 0, 1);
+    double *****D = darray5(1, 4, 1, 3, 1, 2, 0, 2, 0, 1);
+    double n = 0;
+    for (int i = 1; i <= 4; i++)
+        for (int j = 1; j <= 3; j++)
+            for (int k = 1; k <= 2; k++)
+                for (int l = 0; l <= 2; l++)
+                    for (int m = 0; m <= 1; m++) {
+                        A(i,j,k,l,m) = n;
+                        D[i][j][k][l][m] = n;
+                        n += 1;
+                    }
+    for (size_t c = 0; c < A.count; c++)
+        EXPECT_EQ(A.data[c], D[1][1][1][0][c]);
+    EXPECT_EQ(A.level(2,1)[A.index(3,2,1)], D[3][2][1][2][1]);
+    freedarray5(D, 1, 4, 1, 3, 1, 2, 0, 2, 0, 1);
+    freefield(A);
+}
+
+TEST(FieldTest, ArenaPlansThenCarves) {
+    arenaplan();
+    Field A = field3(1, 5, 1, 4, 1, 3, "A");
+    Field B = field4(1, 5, 1, 4, 1, 3, 0, 2, "B");
+    EXPECT_TRUE(A.data == NULL);
+    // Exact sizes, each array rounded up to a whole cache line plus one spare (stagger)
+    unsigned long long a = (5*fieldextent(3,1,4)*fieldextent(3,2,3)*8 + FIELD_ALIGN - 1) / FIELD_ALIGN * FIELD_ALIGN + FIELD_ALIGN;
+    unsigned long long b = (5*4*3*3*8 + FIELD_ALIGN - 1) / FIELD_ALIGN * FIELD_ALIGN + FIELD_ALIGN;
+    EXPECT_EQ(arenabytes(), a + b);
+    EXPECT_EQ(arenareserve(), a + b);
+    A = field3(1, 5, 1, 4, 1, 3, "A");
+    B = field4(1, 5, 1, 4, 1, 3, 0, 2, "B");
+    EXPECT_EQ((uintptr_t)A.data % FIELD_ALIGN, 0u);
+    EXPECT_EQ((uintptr_t)B.data % FIELD_ALIGN, 0u);
+    EXPECT_EQ((char *)B.data - (char *)A.data, (long)a);
+    A(5,4,3) = 1.0;
+    B(5,4,3,2) = 2.0;
+    freefield(A);                       // No-op for arena memory
+    arenarelease();
+    EXPECT_EQ(arenabytes(), 0u);
+}
+
+TEST(FieldTest, GridPaddingIsSharedAndConflictFree) {
+    // 70x70x65 dipole grid: k 65 -> 72 (9 lines), j 70 -> 71
+    Field A = field3(1, 70, 1, 70, 1, 65);
+    int lo[3] = {1, 1, 1}, hi[3] = {70, 70, 65};
+    IdField M = fieldalloc<unsigned char>(3, lo, hi);
+    EXPECT_EQ(A.s[2], 1);
+    EXPECT_EQ(A.s[1], 72);
+    EXPECT_EQ(A.s[0], 71*72);
+    EXPECT_EQ(M.s[1], A.s[1]);
+    EXPECT_EQ(M.s[0], A.s[0]);
+    EXPECT_EQ(A.index(70,70,65), M.index(70,70,65));
+    // Power of two grids: no stride is a whole 4 KB way
+    Field P = field3(1, 128, 1, 128, 1, 128);
+    EXPECT_EQ(P.s[1], 128);
+    EXPECT_NE((P.s[0]*sizeof(double)) % 4096, 0u);
+    Field W = field3(1, 4, 1, 4, 1, 512);
+    EXPECT_EQ(W.s[1] % (long)(FIELD_ALIGN/sizeof(double)), 0);
+    EXPECT_NE((W.s[1]*sizeof(double)) % 4096, 0u);
+    EXPECT_NE((W.s[0]*sizeof(double)) % 4096, 0u);
+    // Dense when switched off
+    fieldpadding(0);
+    Field D = field3(1, 128, 1, 128, 1, 128);
+    EXPECT_EQ(D.s[0], 128*128);
+    fieldpadding(1);
+    freefield(A);
+    freefield(M);
+    freefield(P);
+    freefield(W);
+    freefield(D);
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fields/field_kernels.h"
+#include "utils/memallocate.h"
+
+static const int nx = 6, ny = 5, nz = 21;
+
+// Random E, B, old B (F[0..8]), material map and per material coefficients
+struct KernelGrid {
+    EBField F[9];
+    IdField M;
+    double ca[3][256], cb[3][256];
+
+    KernelGrid() {
+        int lo[3] = {1, 1, 1}, hi[3] = {nx, ny, nz};
+        M = fieldalloc<unsigned char>(3, lo, hi);
+        srand(7);
+        for (int t = 0; t < 9; t++) {
+            F[t] = ebfield3(1, nx, 1, ny, 1, nz);
+            for (size_t c = 0; c < F[t].count; c++)
+                F[t].data[c] = (ebreal)(rand() / (double)RAND_MAX - 0.5);
+        }
+        for (size_t c = 0; c < M.count; c++)
+            M.data[c] = (unsigned char)(rand() & 0xff);
+        for (int j = 1; j <= ny; j++)
+            for (int k = 1; k <= nz; k++)
+                M(3, j, k) = (unsigned char)(9 * j);
+        for (int t = 0; t < 256; t++)
+            for (int d = 0; d < 3; d++) {
+                ca[d][t] = 1.0 - ((t >> (2*d)) & 3) * 0.1;
+                cb[d][t] = 1.0 / (1 + ((t >> (2*d)) & 3));
+            }
+    }
+    ~KernelGrid() {
+        for (int t = 0; t < 9; t++)
+            freefield(F[t]);
+        freefield(M);
+    }
+
+    // E from B, then B from the new E with the selected kernels, new E and B in O[0..5]
+    void run(EBField O[6], double cdx, double cdy, double cdz) {
+        for (int t = 0; t < 6; t++) {
+            O[t] = ebfield3(1, nx, 1, ny, 1, nz);
+            memcpy(O[t].data, F[t].data, F[t].bytes());
+        }
+        ERowArgs e = {O[0].base, O[1].base, O[2].base, F[3].base, F[4].base, F[5].base,
+                      M.base, ca[0], ca[1], ca[2], cb[0], cb[1], cb[2], F[0].s[0], F[0].s[1], cdx, cdy, cdz};
+        BRowArgs b = {F[6].base, F[7].base, F[8].base, O[3].base, O[4].base, O[5].base,
+                      O[0].base, O[1].base, O[2].base, F[0].s[0], F[0].s[1], cdz, cdy, cdx};
+        for (int i = 2; i < nx; i++)
+            for (int j = 2; j < ny; j++)
+                Erow(e, F[0].index(i, j, 2), nz - 2);
+        for (int i = 2; i < nx; i++)
+            for (int j = 2; j < ny; j++)
+                Brow(b, F[0].index(i, j, 2), nz - 2);
+    }
+};
+
+// Runs every E and B row kernel this CPU supports over a small grid and checks the
+// result against the scalar kernel bit for bit, for the general and the cubic cell
+// forms. k has 19 cells so the vector loops and their scalar remainders are both used,
+// the i = 3 rows are of one material so the uniform coefficient path is covered as well.
+TEST(FieldKernelsTest, VectorMatchesScalarExactly) {
+    KernelGrid g;
+    EBField Ref[6], R[6];
+
+    for (int u = 0; u <= 1; u++) {
+        FIELDuniform(u);
+        for (int isa = FIELD_SCALAR; isa <= FIELDcpu(); isa++) {
+            ASSERT_EQ(FIELDselect(isa), 0);
+            EBField *O = (isa == FIELD_SCALAR) ? Ref : R;
+            if (u)
+                g.run(O, 0.2, 0.2, 0.2);
+            else
+                g.run(O, 0.3, 0.2, 0.1);
+            if (isa != FIELD_SCALAR)
+                for (int t = 0; t < 6; t++) {
+                    EXPECT_EQ(memcmp(R[t].data, Ref[t].data, Ref[t].bytes()), 0)
+                        << FIELDname(isa) << " uniform " << u << " array " << t;
+                    freefield(R[t]);
+                }
+        }
+        for (int t = 0; t < 6; t++)
+            freefield(Ref[t]);
+    }
+    FIELDuniform(0);
+    FIELDselect(FIELD_SCALAR);
+}
+
+// The cubic cell form folds cd into the curl, it agrees with the general form to rounding
+TEST(FieldKernelsTest, CubicFormMatchesGeneral) {
+    KernelGrid g;
+    EBField A[6], B[6];
+    const double tol = (sizeof(ebreal) == sizeof(float)) ? 1e-6 : 1e-14;
+
+    ASSERT_EQ(FIELDselect(FIELD_SCALAR), 0);
+    g.run(A, 0.2, 0.2, 0.2);
+    FIELDuniform(1);
+    g.run(B, 0.2, 0.2, 0.2);
+    FIELDuniform(0);
+    for (int t = 0; t < 6; t++) {
+        for (size_t c = 0; c < A[t].count; c++)
+            ASSERT_NEAR(A[t].data[c], B[t].data[c], tol) << "array " << t;
+        freefield(A[t]);
+        freefield(B[t]);
+    }
+}
+
+TEST(FieldKernelsTest, NamesAndSupport) {
+    EXPECT_EQ(FIELDisa("scalar"), FIELD_SCALAR);
+    EXPECT_EQ(FIELDisa("avx2"), FIELD_AVX2);
+    EXPECT_EQ(FIELDisa("neon"), -1);
+    EXPECT_STREQ(FIELDname(FIELD_AVX512), "avx512");
+    EXPECT_EQ(FIELDselect(-1), 1);
+    EXPECT_EQ(FIELDselect(FIELDcpu() + 1), 1);
+    EXPECT_EQ(FIELDselect(FIELD_SCALAR), 0);
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "fields/material.h"
+#include "fields/spans.h"
+#include "utils/memallocate.h"
+
+int sx = 3, sy = 2, sz = 2;
+double dt = 1e-11;
+
+TEST(MaterialTest, TablesMatchOldCoefficients) {
+    MATtables(4.0, 2.0, 0.5);
+    int id = (MAT_PEC << MAT_SHX) | (MAT_ER1 << MAT_SHY) | (MAT_ER2 << MAT_SHZ) | MAT_QF;
+    EXPECT_EQ(MATERX[id], 0.0);
+    EXPECT_EQ(MATERY[id], 1/4.0);
+    EXPECT_EQ(MATERZ[id], 1/2.0);
+    EXPECT_EQ(MATQF[id], 0.5);
+    EXPECT_EQ(MATSIG[id], 0.0);
+    EXPECT_EQ(MATERX[MAT_SIG], 1.0);
+    EXPECT_EQ(MATQF[MAT_SIG], 1.0);
+    EXPECT_EQ(MATSIG[MAT_SIG], 1.0);
+    // Lossless: CA = 1, CB = 1/Er exactly (PEC 0)
+    EXPECT_EQ(MATCAX[id], 1.0);
+    EXPECT_EQ(MATCBX[id], 0.0);
+    EXPECT_EQ(MATCAY[id], 1.0);
+    EXPECT_EQ(MATCBY[id], 1/4.0);
+    EXPECT_EQ(MATCBZ[id], 1/2.0);
+}
+
+TEST(MaterialTest, LossyDielectricCoefficients) {
+    MATtables(4.0, 2.0, 1.0, 0.5, 0);
+    int id = (MAT_ER1 << MAT_SHX) | (MAT_ER2 << MAT_SHY);
+    double l = 0.5*dt/(2*8.85418781762038985e-12*4.0);
+    EXPECT_DOUBLE_EQ(MATCAX[id], (1-l)/(1+l));
+    EXPECT_DOUBLE_EQ(MATCBX[id], 0.25/(1+l));
+    EXPECT_EQ(MATERX[id], 0.25);
+    EXPECT_EQ(MATCAY[id], 1.0);
+    EXPECT_EQ(MATCBY[id], 0.5);
+    EXPECT_EQ(MATCAZ[id], 1.0);
+    EXPECT_EQ(MATCBZ[id], 1.0);
+}
+
+TEST(MaterialTest, SetClassKeepsOtherBits) {
+    MATallocate();
+    MATclear();
+    MAT(2,1,2) = MAT_SIG;
+    MATsetclass(2, 1, 2, MAT_SHY, MAT_ER2);
+    MATsetclass(2, 1, 2, MAT_SHY, MAT_PEC);
+    EXPECT_EQ(MAT(2,1,2), MAT_SIG | (MAT_PEC << MAT_SHY));
+    EXPECT_EQ(MAT(1,1,1), 0);
+    freefield(MAT);
+}
+
+TEST(MaterialTest, SpansRunLengthEncodeRows) {
+    int ox = sx, oy = sy, oz = sz;
+    sx = 4; sy = 3; sz = 8;                     // Interior rows (2,2) and (3,2), k 2..7
+    MATallocate();
+    MATclear();
+    MAT(2,2,4) = MAT_SIG;
+    MAT(2,2,5) = MAT_SIG;
+    MATsetclass(3, 2, 7, MAT_SHX, MAT_PEC);
+    SPANbuild();
+    ASSERT_EQ(SROW[0], 0);
+    ASSERT_EQ(SROW[1], 3);
+    ASSERT_EQ(SROW[2], 4);
+    EXPECT_EQ(SPANS[1].k0, 4);
+    EXPECT_EQ(SPANS[1].k1, 6);
+    EXPECT_EQ(SPANclass(SPANS[1].id), SPAN_PLASMA);
+    EXPECT_EQ(SPANS[2].k1, 8);
+    // The PEC cell does not cut the run of row (3,2), it is in the sparse list
+    EXPECT_EQ(SPANS[3].k0, 2);
+    EXPECT_EQ(SPANS[3].k1, 8);
+    EXPECT_EQ(SPANclass(SPANS[3].id), SPAN_VACUUM);
+    ASSERT_EQ(PROW[1], 0);
+    ASSERT_EQ(PROW[2], 1);
+    EXPECT_EQ(PECS[0].k, 7);
+    EXPECT_EQ(PECS[0].mask, PEC_X);
+    EXPECT_EQ(SPANclass(MAT(3,2,7)), SPAN_PEC);
+    EXPECT_EQ(SPANbulk(MAT(3,2,7) | MAT_QF | (MAT_ER1 << MAT_SHY)), MAT_QF | (MAT_ER1 << MAT_SHY));
+    EXPECT_EQ(SPANclass(MAT_ER1 << MAT_SHZ), SPAN_DIELECTRIC);
+    SPANfree();
+    freefield(MAT);
+    sx = ox; sy = oy; sz = oz;
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include "physics/plasma.h"
+
+// Grid, fields and helpers plasma.cpp links against, PLASMAspecies uses none of them
+// (sx, sy, sz and dt come from test_material.cpp)
+double dx, dy, dz;
+EBField EX, EY, EZ, BX, BY, BZ, BXP, BYP, BZP;
+int FUSE = 1, TILE_J = 0, TILE_K = 0;
+double TILEclock() { return 0; }
+void TILEcount(int, double, double) {}
+void UBCcalc() {}
+void NBCcalc() {}
+
+static const double mass[3] = {9.1066e-31, 2.6566e-26, 4.9824e-26};
+static const double charge[3] = {-1, 1, 1};
+
+TEST(SpeciesTest, BuiltInTable) {
+    ASSERT_EQ(PLASMAspecies(2, NULL, NULL, NULL), 0);
+    EXPECT_EQ(NS, 2);
+    EXPECT_EQ(M[1], 2.6566e-26);
+    EXPECT_LT(Q[0], 0);
+    EXPECT_GT(Q[1], 0);
+    EXPECT_EQ(PLASMAspecies(0, NULL, NULL, NULL), 1);
+    EXPECT_EQ(PLASMAspecies(5, NULL, NULL, NULL), 1);
+}
+
+TEST(SpeciesTest, FileTable) {
+    const double pop[3] = {1, 0.75, 0.25};
+    const double ion[3] = {1, -1, 1};
+
+    ASSERT_EQ(PLASMAspecies(3, mass, charge, pop), 0);
+    EXPECT_EQ(NS, 3);
+    EXPECT_EQ(M[2], 4.9824e-26);
+    // The first species must be the electrons
+    EXPECT_EQ(PLASMAspecies(3, mass, ion, pop), 1);
+    EXPECT_EQ(PLASMAspecies(2, mass+1, charge+1, pop), 1);
+}
+
+// A zero population gives N_0 = 0 (0/0 in the pressure term), with only one ion also a
+// zero sum of the ion populations, both must be rejected (as are negative ones and a
+// zero mass)
+TEST(SpeciesTest, RejectsZeroPopulation) {
+    const double pop3[3] = {1, 1, 0};
+    const double pop2[2] = {1, 0};
+    const double neg[3] = {1, -0.5, 1};
+    const double pop[3] = {1, 0.75, 0.25};
+    const double massless[3] = {9.1066e-31, 0, 4.9824e-26};
+
+    EXPECT_EQ(PLASMAspecies(3, mass, charge, pop3), 1);
+    EXPECT_EQ(PLASMAspecies(2, mass, charge, pop2), 1);
+    EXPECT_EQ(PLASMAspecies(3, mass, charge, neg), 1);
+    EXPECT_EQ(PLASMAspecies(3, massless, charge, pop), 1);
+    EXPECT_EQ(PLASMAspecies(2, mass, charge, pop3), 0);
+}